@@ -1,4 +1,6 @@
 #include "eosio.nft.hpp"
+#include <algorithm>
+#include <map>
 using namespace eosio;
 
 ACTION nft::create( name issuer, std::string sym ) {
@@ -56,29 +58,338 @@ ACTION nft::issue( name to,
         eosio_assert( quantity.amount > 0, "must issue positive quantity of NFT" );
         eosio_assert( symbol == st.supply.symbol, "symbol precision mismatch" );
 
+        // Token name and base uri are stored once per symbol
+        collection_index collections( _self, _self.value );
+        auto existing_collection = set_collection_name( collections, st, tkn_name );
+
+        // Check that number of tokens matches uri size. Without uris
+        // token uris are the base uri followed by the token id
+        eosio_assert( token_uris || uris.empty(), "this build issues tokens without uris" );
+        if( uris.empty() ) {
+            eosio_assert( !existing_collection->base_uri.empty(), "base uri must be set to issue tokens without uris" );
+        } else {
+            eosio_assert( static_cast<uint64_t>(quantity.amount) == uris.size(), "mismatch between number of tokens and uris provided" );
+        }
+
+        mint_batch( to, quantity, uris, {}, batch_name( existing_collection, tkn_name ), st.issuer );
+}
+
+ACTION nft::issuemany( symbol_code sym,
+                       vector<issue_leg> legs,
+                       string tkn_name,
+                       string memo ) {
+
+        eosio_assert( sym.is_valid(), "invalid symbol name" );
+        eosio_assert( memo.size() <= 256, "memo has more than 256 bytes" );
+        eosio_assert( tkn_name.size() <= 32, "name has more than 32 bytes" );
+        eosio_assert( !legs.empty(), "must issue positive quantity of NFT" );
+
+        // Stat row, issuer authorization and collection are checked once for all legs
+        currency_index currency_table( _self, sym.raw() );
+        auto existing_currency = currency_table.find( sym.raw() );
+        eosio_assert( existing_currency != currency_table.end(), "token with symbol does not exist. create token before issue" );
+        const auto& st = *existing_currency;
+
+        require_auth( st.issuer );
+
+        collection_index collections( _self, _self.value );
+        auto existing_collection = set_collection_name( collections, st, tkn_name );
+
+        // Number of tokens per recipient, each balance row is written once
+        std::map<name, int64_t> counts;
+        for( const auto& leg: legs ) {
+            eosio_assert( counts.count( leg.to ) || is_account( leg.to ), "to account does not exist" );
+            eosio_assert( token_uris || leg.uri.empty(), "this build issues tokens without uris" );
+            eosio_assert( !leg.uri.empty() || !existing_collection->base_uri.empty(), "base uri must be set to issue tokens without uris" );
+            counts[leg.to]++;
+        }
+
+        asset quantity{static_cast<int64_t>(legs.size()), st.supply.symbol};
+        add_supply( quantity );
+
+        // One batch record for all consecutive ids
+        auto id = reserve_ids( legs.size() );
+        add_batch( id, legs.size(), sym, batch_name( existing_collection, tkn_name ), st.issuer );
+
+        token_index tokens( _self, sym.raw() );
+        auto next = id;
+        for( const auto& leg: legs ) {
+            mint( tokens, next, leg.to, st.issuer, leg.uri, existing_collection->base_uri.empty() );
+            log_change( "mint"_n, next++, 1, name(), leg.to );
+        }
+
+        if constexpr( !balance_rows )
+            return;
+        if( existing_collection->no_balances )
+            return;
+
+        for( const auto& count: counts ) {
+            add_balance( count.first, asset{count.second, st.supply.symbol}, st.issuer );
+        }
+}
+
+ACTION nft::issuehash( name to,
+                       asset quantity,
+                       vector<checksum256> hashes,
+                       string tkn_name,
+                       string memo ) {
+
+	eosio_assert( is_account( to ), "to account does not exist");
+
+        auto symbol = quantity.symbol;
+        eosio_assert( symbol.is_valid(), "invalid symbol name" );
+        eosio_assert( symbol.precision() == 0, "quantity must be a whole number" );
+        eosio_assert( memo.size() <= 256, "memo has more than 256 bytes" );
+
+	eosio_assert( tkn_name.size() <= 32, "name has more than 32 bytes" );
+
+        // Ensure currency has been created
+        auto symbol_name = symbol.code().raw();
+        currency_index currency_table( _self, symbol_name );
+        auto existing_currency = currency_table.find( symbol_name );
+        eosio_assert( existing_currency != currency_table.end(), "token with symbol does not exist. create token before issue" );
+        const auto& st = *existing_currency;
+
+        // Ensure have issuer authorization and valid quantity
+        require_auth( st.issuer );
+        eosio_assert( quantity.is_valid(), "invalid quantity" );
+        eosio_assert( quantity.amount > 0, "must issue positive quantity of NFT" );
+        eosio_assert( symbol == st.supply.symbol, "symbol precision mismatch" );
+
+        collection_index collections( _self, _self.value );
+        auto existing_collection = set_collection_name( collections, st, tkn_name );
+
+        // Uris of hashed tokens are rebuilt from the base uri, the gateway
+        eosio_assert( !existing_collection->base_uri.empty(), "base uri must be set to issue tokens by hash" );
+        eosio_assert( static_cast<uint64_t>(quantity.amount) == hashes.size(), "mismatch between number of tokens and hashes provided" );
+
+        mint_batch( to, quantity, {}, hashes, batch_name( existing_collection, tkn_name ), st.issuer );
+}
+
+#if NFT_TOKEN_URIS
+ACTION nft::beginissue( name to,
+                        asset quantity,
+                        string tkn_name,
+                        string memo ) {
+
+	eosio_assert( is_account( to ), "to account does not exist");
+
+        auto symbol = quantity.symbol;
+        eosio_assert( symbol.is_valid(), "invalid symbol name" );
+        eosio_assert( symbol.precision() == 0, "quantity must be a whole number" );
+        eosio_assert( memo.size() <= 256, "memo has more than 256 bytes" );
+
+	eosio_assert( tkn_name.size() <= 32, "name has more than 32 bytes" );
+
+        // Ensure currency has been created
+        auto symbol_name = symbol.code().raw();
+        currency_index currency_table( _self, symbol_name );
+        auto existing_currency = currency_table.find( symbol_name );
+        eosio_assert( existing_currency != currency_table.end(), "token with symbol does not exist. create token before issue" );
+        const auto& st = *existing_currency;
+
+        // Ensure have issuer authorization and valid quantity
+        require_auth( st.issuer );
+        eosio_assert( quantity.is_valid(), "invalid quantity" );
+        eosio_assert( quantity.amount > 0, "must issue positive quantity of NFT" );
+        eosio_assert( symbol == st.supply.symbol, "symbol precision mismatch" );
+
+        // Name is fixed when the job starts, chunks only bring uris
+        collection_index collections( _self, _self.value );
+        auto existing_collection = set_collection_name( collections, st, tkn_name );
+
+        issuejob_index jobs( _self, _self.value );
+        auto job = jobs.emplace( st.issuer, [&]( auto& job ) {
+            job.id = jobs.available_primary_key();
+            job.to = to;
+            job.quantity = quantity;
+            job.issued = 0;
+            job.tokenName = batch_name( existing_collection, tkn_name );
+        });
+
+        print( "job id: ", job->id );
+}
+
+ACTION nft::continueissue( uint64_t job_id, vector<string> uris ) {
+
+	issuejob_index jobs( _self, _self.value );
+	const auto& job = jobs.get( job_id, "issue job does not exist" );
+
+	currency_index currency_table( _self, job.quantity.symbol.code().raw() );
+	const auto& st = currency_table.get( job.quantity.symbol.code().raw(), "token with symbol does not exist" );
+
+	// Ensure have issuer authorization
+	require_auth( st.issuer );
+
+	// Each call mints one chunk, sized by the caller to fit a transaction
+	eosio_assert( !uris.empty(), "no uris provided" );
+	eosio_assert( uris.size() <= static_cast<uint64_t>(job.quantity.amount) - job.issued, "more uris than tokens left in issue job" );
+
+	asset chunk{static_cast<int64_t>(uris.size()), job.quantity.symbol};
+	mint_batch( job.to, chunk, uris, {}, job.tokenName, st.issuer );
+
+	// Close the job once every token is minted
+	if( job.issued + uris.size() == static_cast<uint64_t>(job.quantity.amount) ) {
+		jobs.erase( job );
+	} else {
+		jobs.modify( job, name(0), [&]( auto& job ) {
+			job.issued += uris.size();
+		});
+	}
+}
+#endif
+
+nft::collection_index::const_iterator nft::set_collection_name( collection_index& collections,
+                                                                const stats& st,
+                                                                const string& tkn_name ) {
+
+        auto existing_collection = collections.find( st.supply.symbol.code().raw() );
+        if( existing_collection == collections.end() ) {
+            existing_collection = collections.emplace( st.issuer, [&]( auto& collection ) {
+                collection.sym = st.supply.symbol.code();
+                collection.tokenName = tkn_name;
+            });
+        } else if( existing_collection->tokenName != tkn_name && st.supply.amount == 0 ) {
+            // Name of the collection follows the issue while no tokens of the
+            // symbol exist, later issues under another name keep it on their batch
+            collections.modify( existing_collection, st.issuer, [&]( auto& collection ) {
+                collection.tokenName = tkn_name;
+            });
+        }
+
+        return existing_collection;
+}
+
+string nft::batch_name( collection_index::const_iterator collection, const string& tkn_name ) {
+
+        // Tokens named like their collection store no name of their own
+        if( collection->tokenName == tkn_name )
+            return string();
+
+        eosio_assert( token_names, "this build keeps no per-token names" );
+        return tkn_name;
+}
+
+void nft::mint_batch( name to, asset quantity, const vector<string>& uris, const vector<checksum256>& hashes, const string& tkn_name, name issuer ) {
+
         // Increase supply
 	add_supply( quantity );
 
-        // Check that number of tokens matches uri size
-        eosio_assert( quantity.amount == uris.size(), "mismatch between number of tokens and uris provided" );
-
         // Mint nfts
-        for(auto const& uri: uris) {
-            mint( to, st.issuer, asset{1, symbol}, uri, tkn_name);
+        auto symbol = quantity.symbol;
+        auto id = reserve_ids( quantity.amount );
+        add_batch( id, quantity.amount, symbol.code(), tkn_name, issuer );
+
+        if( !hashes.empty() ) {
+            // Fixed size rows, no metadata row
+            hashtoken_index hashed( _self, symbol.code().raw() );
+            auto next = id;
+            for(auto const& hash: hashes) {
+                hashed.emplace( issuer, [&]( auto& token ) {
+                    token.id = next;
+                    token.content_hash = hash;
+                    token.owner = to;
+                    token.sym = symbol.code();
+                });
+                add_holding( to, next++, 1, symbol.code(), issuer );
+            }
+        } else if( uris.empty() ) {
+            // One record for the whole batch, rows are created on first touch
+            range_index ranges( _self, symbol.code().raw() );
+            ranges.emplace( issuer, [&]( auto& range ) {
+                range.start = id;
+                range.count = quantity.amount;
+                range.owner = to;
+                range.sym = symbol.code();
+            });
+            add_holding( to, id, quantity.amount, symbol.code(), issuer );
+        } else {
+            // Uris issued while the collection has no base uri are kept
+            // whole, a base uri set later is not prepended to them
+            collection_index collections( _self, _self.value );
+            bool absolute = collections.get( symbol.code().raw(), "collection does not exist" ).base_uri.empty();
+
+            token_index tokens( _self, symbol.code().raw() );
+            auto next = id;
+            for(auto const& uri: uris) {
+                mint( tokens, next++, to, issuer, uri, absolute );
+            }
         }
 
+        // One change for the whole batch of consecutive ids
+        log_change( "mint"_n, id, quantity.amount, name(), to );
+
         // Add balance to account
-        add_balance( to, quantity, st.issuer );
+        if( keeps_balances( symbol.code() ) )
+            add_balance( to, quantity, issuer );
 }
 
 
+ACTION nft::setbaseuri( symbol_code sym, string base_uri ) {
+
+	eosio_assert( sym.is_valid(), "invalid symbol name" );
+	eosio_assert( base_uri.size() <= 256, "base uri has more than 256 bytes" );
+
+	// Ensure currency has been created
+	currency_index currency_table( _self, sym.raw() );
+	const auto& st = currency_table.get( sym.raw(), "token with symbol does not exist" );
+
+	// Ensure have issuer authorization
+	require_auth( st.issuer );
+
+	collection_index collections( _self, _self.value );
+	auto existing_collection = collections.find( sym.raw() );
+	if( existing_collection == collections.end() ) {
+		collections.emplace( st.issuer, [&]( auto& collection ) {
+			collection.sym = sym;
+			collection.base_uri = base_uri;
+		});
+	} else {
+		collections.modify( existing_collection, st.issuer, [&]( auto& collection ) {
+			collection.base_uri = base_uri;
+		});
+	}
+}
+
+#if NFT_BALANCES
+ACTION nft::setbalances( symbol_code sym, bool keep ) {
+
+	eosio_assert( sym.is_valid(), "invalid symbol name" );
+
+	// Ensure currency has been created
+	currency_index currency_table( _self, sym.raw() );
+	const auto& st = currency_table.get( sym.raw(), "token with symbol does not exist" );
+
+	// Ensure have issuer authorization
+	require_auth( st.issuer );
+
+	// Balance rows would no longer match the tokens
+	eosio_assert( st.supply.amount == 0, "balance mode can only change before tokens are issued" );
+
+	collection_index collections( _self, _self.value );
+	auto existing_collection = collections.find( sym.raw() );
+	if( existing_collection == collections.end() ) {
+		collections.emplace( st.issuer, [&]( auto& collection ) {
+			collection.sym = sym;
+			collection.no_balances = !keep;
+		});
+	} else {
+		collections.modify( existing_collection, st.issuer, [&]( auto& collection ) {
+			collection.no_balances = !keep;
+		});
+	}
+}
+#endif
+
+
 ACTION nft::transferid( name	from,
                         name 	to,
                         id_type	id,
                         string	memo ) {
-        // Ensure authorized to send from account
+        // Ensure authorized to send from account, the account
+        // that authorized the transfer pays for new rows
         eosio_assert( from != to, "cannot transfer to self" );
-        require_auth( from );
+        name payer = transfer_authority( from, id );
 
         // Ensure 'to' account exists
         eosio_assert( is_account( to ), "to account does not exist");
@@ -87,35 +398,77 @@ ACTION nft::transferid( name	from,
         eosio_assert( memo.size() <= 256, "memo has more than 256 bytes" );
 
         // Ensure token ID exists
-        auto send_token = tokens.find( id );
-        eosio_assert( send_token != tokens.end(), "token with specified ID does not exist" );
-
-	// Ensure owner owns token
-        eosio_assert( send_token->owner == from, "sender does not own token with specified ID");
-
-	const auto& st = *send_token;
+        auto sym = symbol_of( id );
+        eosio_assert( sym.raw() != 0, "token with specified ID does not exist" );
 
 	// Notify both recipients
         require_recipient( from );
         require_recipient( to );
 
         // Transfer NFT from sender to receiver
-        tokens.modify( send_token, from, [&]( auto& token ) {
-	        token.owner = to;
-        });
+        token_index tokens( _self, sym.raw() );
+        asset value = move_token( tokens, from, to, id, payer );
 
         // Change balance of both accounts
-        sub_balance( from, st.value );
-        add_balance( to, st.value, from );
+        if( keeps_balances( sym ) ) {
+            sub_balance( from, value );
+            add_balance( to, value, payer );
+        }
+}
+
+ACTION nft::transferids( name		from,
+                         name		to,
+                         vector<id_type>	ids,
+                         string		memo ) {
+        eosio_assert( from != to, "cannot transfer to self" );
+
+        // Ensure 'to' account exists
+        eosio_assert( is_account( to ), "to account does not exist");
+
+	// Check memo size and print
+        eosio_assert( memo.size() <= 256, "memo has more than 256 bytes" );
+
+	eosio_assert( !ids.empty(), "no token ids provided" );
+
+	// Notify both recipients once for the whole batch
+        require_recipient( from );
+        require_recipient( to );
+
+	// Amount moved per symbol, and the authority of the first
+	// id of each symbol, which pays for the receiver's balance row
+	vector<asset> moved;
+	vector<name> payers;
+
+	for( auto id: ids ) {
+		// Ensure authorized to send each token from account
+		name payer = transfer_authority( from, id );
+
+		// Ensure token ID exists
+		auto sym = symbol_of( id );
+		eosio_assert( sym.raw() != 0, "token with specified ID does not exist" );
+
+		// Transfer NFT from sender to receiver, the ownership
+		// check also rejects ids listed twice
+		token_index tokens( _self, sym.raw() );
+		sum_by_symbol( moved, move_token( tokens, from, to, id, payer ) );
+		if( payers.size() < moved.size() )
+			payers.push_back( payer );
+	}
+
+        // Change balance of both accounts once per symbol
+	for( size_t i = 0; i < moved.size(); ++i ) {
+		if( !keeps_balances( moved[i].symbol.code() ) )
+			continue;
+		sub_balance( from, moved[i] );
+		add_balance( to, moved[i], payers[i] );
+	}
 }
 
 ACTION nft::transfer( name 	from,
                       name 	to,
                       asset	quantity,
                       string	memo ) {
-        // Ensure authorized to send from account
         eosio_assert( from != to, "cannot transfer to self" );
-        require_auth( from );
 
         // Ensure 'to' account exists
         eosio_assert( is_account( to ), "to account does not exist");
@@ -125,43 +478,473 @@ ACTION nft::transfer( name 	from,
 
 	eosio_assert( quantity.amount == 1, "cannot transfer quantity, not equal to 1" );
 
-	auto symbl = tokens.get_index<"bysymbol"_n>();
+	eosio_assert( quantity.symbol.precision() == 0, "token is not found or is not owned by account" );
 
-	auto it = symbl.lower_bound(quantity.symbol.code().raw());
+	// Single lookup in the owner index of the symbol's
+	// own table instead of scanning every token of the symbol
+	auto symbol_name = quantity.symbol.code().raw();
+	token_index tokens( _self, symbol_name );
+	auto byowner = tokens.get_index<"byowner"_n>();
 
-	bool found = false;
 	id_type id = 0;
-	for(; it!=symbl.end(); ++it){
-
-		if( it->value.symbol == quantity.symbol && it->owner == from) {
-			id = it->id;
-			found = true;
-			break;
+	auto it = byowner.find( from.value );
+	if( it != byowner.end() ) {
+		id = it->id;
+	} else {
+		// First token of a lazily issued range of the sender
+		range_index ranges( _self, symbol_name );
+		auto range_byowner = ranges.get_index<"byowner"_n>();
+		auto r = range_byowner.find( from.value );
+		if( r != range_byowner.end() ) {
+			id = r->start;
+		} else {
+			// Or a content-addressed token
+			hashtoken_index hashed( _self, symbol_name );
+			auto hashed_byowner = hashed.get_index<"byowner"_n>();
+			auto h = hashed_byowner.find( from.value );
+
+			// Or a token not migrated from the legacy table yet
+			id = h != hashed_byowner.end() ? h->id : upgrade_legacy_of( from, quantity.symbol.code() );
 		}
 	}
 
-	eosio_assert(found, "token is not found or is not owned by account");
+        // Ensure authorized to send from account
+	name payer = transfer_authority( from, id );
 
 	// Notify both recipients
         require_recipient( from );
 	require_recipient( to );
 
-	SEND_INLINE_ACTION( *this, transferid, {from, "active"_n}, {from, to, id, memo} );
+	// Move the token in this action, an inline transferid
+	// would repeat every check and notify both parties again
+	asset value = move_token( tokens, from, to, id, payer );
+
+        // Change balance of both accounts
+        if( keeps_balances( quantity.symbol.code() ) ) {
+            sub_balance( from, value );
+            add_balance( to, value, payer );
+        }
 }
 
-void nft::mint( name 	owner,
+ACTION nft::swap( vector<swap_leg>	legs,
+                  string		memo ) {
+
+	eosio_assert( !legs.empty(), "no swap legs provided" );
+
+	// Check memo size and print
+        eosio_assert( memo.size() <= 256, "memo has more than 256 bytes" );
+
+	// Validate every leg against the state before the swap, so
+	// a token can not be passed on by the account receiving it
+	vector<name> payers;
+	for( size_t i = 0; i < legs.size(); ++i ) {
+		const auto& leg = legs[i];
+		eosio_assert( leg.from != leg.to, "cannot transfer to self" );
+		eosio_assert( is_account( leg.to ), "to account does not exist");
+
+		for( size_t j = 0; j < i; ++j )
+			eosio_assert( legs[j].id != leg.id, "token listed in more than one leg" );
+
+		eosio_assert( owner_of( leg.id ) == leg.from, "sender does not own token with specified ID" );
+
+		// Owner, an operator of the owner or the token's approved spender
+		payers.push_back( transfer_authority( leg.from, leg.id ) );
+	}
+
+	// Net balance change per account and symbol, and the
+	// account paying for a balance row created by it
+	vector<std::pair<name, asset>> deltas;
+	vector<name> delta_payers;
+	auto add_delta = [&]( name owner, const asset& quantity, name ram_payer ) {
+		for( size_t i = 0; i < deltas.size(); ++i ) {
+			if( deltas[i].first == owner && deltas[i].second.symbol == quantity.symbol ) {
+				deltas[i].second += quantity;
+				delta_payers[i] = ram_payer;
+				return;
+			}
+		}
+		deltas.emplace_back( owner, quantity );
+		delta_payers.push_back( ram_payer );
+	};
+
+	for( size_t i = 0; i < legs.size(); ++i ) {
+		const auto& leg = legs[i];
+
+		// Notified once however many legs an account is part of
+		require_recipient( leg.from );
+		require_recipient( leg.to );
+
+		token_index tokens( _self, symbol_of( leg.id ).raw() );
+		asset value = move_token( tokens, leg.from, leg.to, leg.id, payers[i] );
+
+		add_delta( leg.from, -value, payers[i] );
+		add_delta( leg.to, value, payers[i] );
+	}
+
+	// Modify each balance row once, an account receiving as many
+	// tokens of a symbol as it gives away is not touched at all
+	for( size_t i = 0; i < deltas.size(); ++i ) {
+		const auto& quantity = deltas[i].second;
+		if( quantity.amount == 0 || !keeps_balances( quantity.symbol.code() ) )
+			continue;
+		if( quantity.amount < 0 ) {
+			sub_balance( deltas[i].first, -quantity );
+		} else if( quantity.amount > 0 ) {
+			add_balance( deltas[i].first, quantity, delta_payers[i] );
+		}
+	}
+}
+
+asset nft::move_token( token_index& tokens, name from, name to, id_type id, name ram_payer ) {
+
+	auto send_token = materialize( tokens, id, ram_payer );
+	if( send_token == tokens.end() )
+		return move_hashed_token( symbol_code( tokens.get_scope() ), from, to, id, ram_payer );
+
+	// Ensure owner owns token
+	eosio_assert( send_token->owner == from, "sender does not own token with specified ID");
+
+	tokens.modify( send_token, ram_payer, [&]( auto& token ) {
+		token.owner = to;
+	});
+	move_holding( from, to, id, ram_payer );
+	log_change( "transfer"_n, id, 1, from, to );
+
+	// Approval ends with the ownership
+	clear_approval( id );
+
+	return send_token->get_value();
+}
+
+ACTION nft::setapproval( name owner, id_type id, name spender ) {
+
+	require_auth( owner );
+
+	eosio_assert( spender != owner, "cannot approve owner" );
+	eosio_assert( !spender || is_account( spender ), "spender account does not exist" );
+	eosio_assert( owner_of( id ) == owner, "sender does not own token with specified ID" );
+
+	// Empty spender revokes the approval
+	approval_index approvals( _self, _self.value );
+	auto existing_approval = approvals.find( id );
+	if( !spender ) {
+		if( existing_approval != approvals.end() )
+			approvals.erase( existing_approval );
+	} else if( existing_approval == approvals.end() ) {
+		approvals.emplace( owner, [&]( auto& approval ) {
+			approval.id = id;
+			approval.spender = spender;
+		});
+	} else {
+		approvals.modify( existing_approval, owner, [&]( auto& approval ) {
+			approval.spender = spender;
+		});
+	}
+}
+
+ACTION nft::approveall( name owner, name spender, bool approved ) {
+
+	require_auth( owner );
+
+	eosio_assert( spender != owner, "cannot approve owner" );
+	eosio_assert( is_account( spender ), "spender account does not exist" );
+
+	operator_index operators( _self, owner.value );
+	auto existing_operator = operators.find( spender.value );
+	if( approved ) {
+		eosio_assert( existing_operator == operators.end(), "operator is already approved" );
+
+		// Transfers check every operator of the owner
+		uint64_t count = 0;
+		for( auto it = operators.begin(); it != operators.end(); ++it )
+			++count;
+		eosio_assert( count < max_operators, "too many operators approved" );
+
+		operators.emplace( owner, [&]( auto& op ) {
+			op.spender = spender;
+		});
+	} else {
+		eosio_assert( existing_operator != operators.end(), "operator is not approved" );
+		operators.erase( existing_operator );
+	}
+}
+
+name nft::transfer_authority( name from, id_type id ) {
+
+	if( has_auth( from ) )
+		return from;
+
+	// Spender approved for this token only. Every authorizer of the
+	// action counts, so several spenders can sign one action and a
+	// contract can call inline
+	approval_index approvals( _self, _self.value );
+	auto approval = approvals.find( id );
+	if( approval != approvals.end() && has_auth( approval->spender ) )
+		return approval->spender;
+
+	// Operators may move every token of the owner, at most
+	// max_operators rows are checked
+	operator_index operators( _self, from.value );
+	for( const auto& op: operators ) {
+		if( has_auth( op.spender ) )
+			return op.spender;
+	}
+
+	require_auth( from );
+	return from;
+}
+
+name nft::owner_of( id_type id ) {
+
+	// Reads only, a token not migrated yet is read from the legacy table
+	auto sym = batch_symbol_of( id );
+	if( sym.raw() == 0 )
+		return legacy_owner_of( id );
+
+	token_index tokens( _self, sym.raw() );
+	auto token = tokens.find( id );
+	if( token != tokens.end() )
+		return token->owner;
+
+	range_index ranges( _self, sym.raw() );
+	auto range = find_range( ranges, id );
+	if( range != ranges.end() )
+		return range->owner;
+
+	hashtoken_index hashed( _self, sym.raw() );
+	auto hashed_token = hashed.find( id );
+	return hashed_token != hashed.end() ? hashed_token->owner : name();
+}
+
+void nft::clear_approval( id_type id ) {
+
+	approval_index approvals( _self, _self.value );
+	auto approval = approvals.find( id );
+	if( approval != approvals.end() ) {
+		approvals.erase( approval );
+	}
+}
+
+asset nft::move_hashed_token( symbol_code sym, name from, name to, id_type id, name ram_payer ) {
+
+	hashtoken_index hashed( _self, sym.raw() );
+	const auto& send_token = hashed.get( id, "token with specified ID does not exist" );
+
+	// Ensure owner owns token
+	eosio_assert( send_token.owner == from, "sender does not own token with specified ID");
+
+	hashed.modify( send_token, ram_payer, [&]( auto& token ) {
+		token.owner = to;
+	});
+	move_holding( from, to, id, ram_payer );
+	log_change( "transfer"_n, id, 1, from, to );
+
+	// Approval ends with the ownership
+	clear_approval( id );
+
+	return send_token.get_value();
+}
+
+id_type nft::reserve_ids( uint64_t count ) {
+
+	global_singleton global_table( _self, _self.value );
+
+	global state;
+	if( global_table.exists() ) {
+		state = global_table.get();
+	} else {
+		// Continue after tokens not migrated yet from the legacy table
+		legacy_token_index legacy( _self, _self.value );
+		state.next_id = legacy.available_primary_key();
+	}
+
+	// Ids must not wrap around onto existing batches
+	id_type first = state.next_id;
+	eosio_assert( state.next_id + count >= state.next_id, "token ids are exhausted" );
+	state.next_id += count;
+	global_table.set( state, _self );
+
+	return first;
+}
+
+void nft::add_batch( id_type start, uint64_t count, symbol_code sym, const string& tkn_name, name ram_payer ) {
+
+	batch_index batches( _self, _self.value );
+
+	// Extend the previous batch when the ids follow it with the same symbol and name
+	auto prev = batches.upper_bound( start );
+	if( prev != batches.begin() ) {
+		--prev;
+		if( prev->start + prev->count == start && prev->sym == sym && prev->tokenName == tkn_name ) {
+			batches.modify( prev, name(0), [&]( auto& batch ) {
+				batch.count += count;
+			});
+			return;
+		}
+	}
+
+	batches.emplace( ram_payer, [&]( auto& batch ) {
+		batch.start = start;
+		batch.count = count;
+		batch.sym = sym;
+		batch.tokenName = tkn_name;
+	});
+}
+
+symbol_code nft::symbol_of( id_type id ) {
+
+	auto sym = batch_symbol_of( id );
+	return sym.raw() != 0 ? sym : upgrade_legacy( id );
+}
+
+symbol_code nft::batch_symbol_of( id_type id ) {
+
+	batch_index batches( _self, _self.value );
+
+	// Last batch starting at or before the id
+	auto batch = batches.upper_bound( id );
+	if( batch == batches.begin() )
+		return symbol_code();
+	--batch;
+
+	return id - batch->start < batch->count ? batch->sym : symbol_code();
+}
+
+string nft::get_name( id_type id ) {
+
+	// Own name of a migrated token
+	if constexpr( token_names ) {
+		tokenname_index names( _self, _self.value );
+		auto own_name = names.find( id );
+		if( own_name != names.end() )
+			return own_name->tokenName;
+	}
+
+	// Name of the batch, or of the collection when the batch has none
+	batch_index batches( _self, _self.value );
+	auto batch = batches.upper_bound( id );
+	eosio_assert( batch != batches.begin(), "token with specified ID does not exist" );
+	--batch;
+	eosio_assert( id - batch->start < batch->count, "token with specified ID does not exist" );
+	if( !batch->tokenName.empty() )
+		return batch->tokenName;
+
+	collection_index collections( _self, _self.value );
+	return collections.get( batch->sym.raw(), "collection does not exist" ).tokenName;
+}
+
+string nft::get_unique_name( id_type id ) {
+
+	return get_name( id ) + "#" + std::to_string( id );
+}
+
+void nft::mint( token_index& tokens,
+                id_type	id,
+                name 	owner,
                 name 	ram_payer,
-                asset 	value,
                 string 	uri,
-		string 	tkn_name) {
+                bool 	absolute ) {
         // Add token with creator paying for RAM
         tokens.emplace( ram_payer, [&]( auto& token ) {
-            token.id = tokens.available_primary_key();
-            token.uri = uri;
+            token.id = id;
             token.owner = owner;
-            token.value = value;
-	    token.tokenName = tkn_name;
+            token.sym = symbol_code( tokens.get_scope() );
         });
+        add_holding( owner, id, 1, symbol_code( tokens.get_scope() ), ram_payer );
+
+        // Metadata row is written once and stays with the creator
+        if constexpr( token_uris ) {
+            if( !uri.empty() ) {
+                tokenmeta_index metas( _self, tokens.get_scope() );
+                metas.emplace( ram_payer, [&]( auto& meta ) {
+                    meta.id = id;
+                    meta.uri = uri;
+                    meta.absolute = absolute;
+                });
+            }
+        }
+}
+
+void nft::add_holding( name owner, id_type id, uint64_t count, symbol_code sym, name ram_payer ) {
+
+	holding_index holdings( _self, owner.value );
+	holdings.emplace( ram_payer, [&]( auto& holding ) {
+		holding.id = id;
+		holding.count = count;
+		holding.sym = sym;
+	});
+}
+
+void nft::move_holding( name from, name to, id_type id, name ram_payer ) {
+
+	holding_index from_holdings( _self, from.value );
+	const auto& holding = from_holdings.get( id, "token is missing from owner inventory" );
+
+	add_holding( to, id, holding.count, holding.sym, ram_payer );
+	from_holdings.erase( holding );
+}
+
+nft::range_index::const_iterator nft::find_range( range_index& ranges, id_type id ) {
+
+	// Last range starting at or before the id
+	auto range = ranges.upper_bound( id );
+	if( range == ranges.begin() )
+		return ranges.end();
+	--range;
+
+	return id - range->start < range->count ? range : ranges.end();
+}
+
+void nft::split_range( range_index& ranges, range_index::const_iterator range, id_type id, name ram_payer ) {
+
+	id_type end = range->start + range->count;
+
+	// The owner's inventory entry for the range is split the same way
+	holding_index holdings( _self, range->owner.value );
+	const auto& holding = holdings.get( range->start, "token is missing from owner inventory" );
+
+	// Tokens after the id get a range record of their own
+	if( id + 1 < end ) {
+		ranges.emplace( ram_payer, [&]( auto& right ) {
+			right.start = id + 1;
+			right.count = end - id - 1;
+			right.owner = range->owner;
+			right.sym = range->sym;
+		});
+		add_holding( range->owner, id + 1, end - id - 1, range->sym, ram_payer );
+	}
+
+	// Tokens before the id stay in the existing record
+	if( id > range->start ) {
+		ranges.modify( range, name(0), [&]( auto& left ) {
+			left.count = id - left.start;
+		});
+		holdings.modify( holding, name(0), [&]( auto& left ) {
+			left.count = id - left.id;
+		});
+	} else {
+		ranges.erase( range );
+		holdings.erase( holding );
+	}
+}
+
+nft::token_index::const_iterator nft::materialize( token_index& tokens, id_type id, name ram_payer ) {
+
+	auto existing_token = tokens.find( id );
+	if( existing_token != tokens.end() )
+		return existing_token;
+
+	range_index ranges( _self, tokens.get_scope() );
+	auto range = find_range( ranges, id );
+	if( range == ranges.end() )
+		return tokens.end();
+
+	// Give the token its own row, its uri is derived from the id
+	name owner = range->owner;
+	split_range( ranges, range, id, ram_payer );
+	mint( tokens, id, owner, ram_payer, string(), false );
+
+	return tokens.find( id );
 }
 
 ACTION nft::setrampayer(name payer, id_type id) {
@@ -169,61 +952,553 @@ ACTION nft::setrampayer(name payer, id_type id) {
 	require_auth(payer);
 
 	// Ensure token ID exists
-	auto payer_token = tokens.find( id );
-	eosio_assert( payer_token != tokens.end(), "token with specified ID does not exist" );
-
-	// Ensure payer owns token
-	eosio_assert( payer_token->owner == payer, "payer does not own token with specified ID");
-
-	const auto& st = *payer_token;
+	auto sym = symbol_of( id );
+	eosio_assert( sym.raw() != 0, "token with specified ID does not exist" );
 
 	// Notify payer
 	require_recipient( payer );
 
-	/*tokens.erase(payer_token);
- 	tokens.emplace(payer, [&](auto& token){
-  		token.id = st.id;
-  		token.uri = st.uri;
-  		token.owner = st.owner;
-  		token.value = st.value;
-  		token.name = st.name;
- 	});*/
-
-	// Set owner as a RAM payer
-	tokens.modify(payer_token, payer, [&](auto& token){
-		token.id = st.id;
-		token.uri = st.uri;
-		token.owner = st.owner;
-		token.value = st.value;
-		token.tokenName = st.tokenName;
-	});
+	token_index tokens( _self, sym.raw() );
+	auto payer_token = materialize( tokens, id, payer );
+	if( payer_token == tokens.end() ) {
+		// Content-addressed tokens have their own table
+		hashtoken_index hashed( _self, sym.raw() );
+		const auto& hashed_token = hashed.get( id, "token with specified ID does not exist" );
+		eosio_assert( hashed_token.owner == payer, "payer does not own token with specified ID");
+		hashed.modify( hashed_token, payer, []( auto& ){} );
+	} else {
+		// Ensure payer owns token
+		eosio_assert( payer_token->owner == payer, "payer does not own token with specified ID");
+
+		// Set owner as a RAM payer, the row itself is unchanged
+		// and the metadata row stays with its creator
+		tokens.modify( payer_token, payer, []( auto& ){} );
+	}
+
+	holding_index holdings( _self, payer.value );
+	holdings.modify( holdings.get( id, "token is missing from owner inventory" ), payer, []( auto& ){} );
+
+	set_balance_payer( payer, sym, payer );
+	log_change( "rampayer"_n, id, 1, payer, payer );
+}
+
+ACTION nft::setrampayers( name payer, symbol_code sym, id_type cursor, uint64_t limit ) {
+
+	require_auth( payer );
+
+	eosio_assert( sym.is_valid(), "invalid symbol name" );
+	eosio_assert( limit > 0, "limit must be positive" );
+
+	token_index tokens( _self, sym.raw() );
+	range_index ranges( _self, sym.raw() );
+	hashtoken_index hashed( _self, sym.raw() );
+
+	// Walk the payer's inventory in id order starting at the cursor,
+	// entries of other symbols count towards the limit but are skipped
+	holding_index holdings( _self, payer.value );
+	auto it = holdings.lower_bound( cursor );
+
+	// Tokens not migrated yet follow the inventory, a cursor naming
+	// one of them continues there
+	legacy_token_index legacy( _self, _self.value );
+	auto byowner = legacy.get_index<"byowner"_n>();
+	auto old = byowner.end();
+	if( !migrated( 1 ) ) {
+		auto named = legacy.find( cursor );
+		if( named != legacy.end() && named->owner == payer ) {
+			it = holdings.end();
+			old = byowner.iterator_to( *named );
+		} else {
+			old = byowner.lower_bound( payer.value );
+		}
+	}
+
+	uint64_t n = 0;
+	for( ; it != holdings.end() && n < limit; ++n, ++it ) {
+		if( it->sym != sym )
+			continue;
+
+		// A token row, a range of tokens that have no rows
+		// yet, or a content-addressed token
+		auto payer_token = tokens.find( it->id );
+		auto range = payer_token == tokens.end() ? ranges.find( it->id ) : ranges.end();
+		if( payer_token != tokens.end() ) {
+			tokens.modify( payer_token, payer, []( auto& ){} );
+		} else if( range != ranges.end() ) {
+			ranges.modify( range, payer, []( auto& ){} );
+		} else {
+			hashed.modify( hashed.get( it->id, "token is missing from owner inventory" ), payer, []( auto& ){} );
+		}
+		holdings.modify( it, payer, []( auto& ){} );
+		log_change( "rampayer"_n, it->id, it->count, payer, payer );
+	}
+
+	// Converted the way any action touching them does, then rebilled
+	for( ; old != byowner.end() && old->owner == payer && n < limit; ++n ) {
+		auto legacy_token = legacy.iterator_to( *old++ );
+		if( legacy_token->value.symbol.code() != sym )
+			continue;
+
+		id_type id = legacy_token->id;
+		convert_legacy( legacy, legacy_token );
+		tokens.modify( tokens.get( id, "token is missing after conversion" ), payer, []( auto& ){} );
+		holdings.modify( holdings.get( id, "token is missing from owner inventory" ), payer, []( auto& ){} );
+		log_change( "rampayer"_n, id, 1, payer, payer );
+	}
+
+	// Balance row is rebilled once per call
+	set_balance_payer( payer, sym, payer );
+
+	// Continue with the next call
+	if( it != holdings.end() )
+		print( "next id: ", it->id );
+	else if( old != byowner.end() && old->owner == payer )
+		print( "next id: ", old->id );
+}
+
+
+ACTION nft::migrate( uint64_t limit ) {
+
+	require_auth( _self );
+
+	eosio_assert( limit > 0, "limit must be positive" );
+
+	// Steps run in order, each converts the rows of one schema version
+	// to the next and may span many calls. Until the last step is done
+	// actions read rows of both versions.
+	migration_singleton migration_table( _self, _self.value );
+	auto state = migration_table.get_or_default( migration{} );
+
+	uint64_t budget = limit;
+	while( state.version < schema_version ) {
+		if( !migrate_step( state.version, state.cursor, budget ) )
+			break;
+		state.version++;
+		state.cursor = 0;
+	}
+	migration_table.set( state, _self );
+
+	// Continue with the next call
+	if( state.version < schema_version )
+		print( "next id: ", state.cursor );
+}
+
+bool nft::migrate_step( uint32_t version, uint64_t& cursor, uint64_t& budget ) {
+
+	switch( version ) {
+	case 0: {
+		// Legacy "token" table to the compact layout, converted
+		// rows leave the table so the cursor only skips ahead
+		legacy_token_index legacy( _self, _self.value );
+		auto it = legacy.lower_bound( cursor );
+		for( ; it != legacy.end() && budget > 0; --budget )
+			it = convert_legacy( legacy, it );
+
+		if( it == legacy.end() )
+			return true;
+		cursor = it->id;
+		return false;
+	}
+	}
+
+	eosio_assert( false, "unknown schema version" );
+	return false;
+}
+
+bool nft::migrated( uint32_t version ) {
+
+	migration_singleton migration_table( _self, _self.value );
+	return migration_table.exists() && migration_table.get().version >= version;
+}
+
+nft::legacy_token_index::const_iterator nft::convert_legacy( legacy_token_index& legacy, legacy_token_index::const_iterator it ) {
+
+	// New ids must continue after the legacy ones once their rows are gone
+	global_singleton global_table( _self, _self.value );
+	if( !global_table.exists() )
+		reserve_ids( 0 );
+
+	// The first migrated token of a symbol sets the collection name,
+	// tokens named differently keep their own name in "tokennames".
+	// Migrated rows are billed to the contract account, owners can
+	// take the RAM back with setrampayer.
+	collection_index collections( _self, _self.value );
+	tokenname_index names( _self, _self.value );
+
+	const auto& old = *it;
+	auto sym = old.value.symbol.code();
+
+	auto existing_collection = collections.find( sym.raw() );
+	if( existing_collection == collections.end() ) {
+		collections.emplace( _self, [&]( auto& collection ) {
+			collection.sym = sym;
+			collection.tokenName = old.tokenName;
+		});
+	} else if( existing_collection->tokenName != old.tokenName ) {
+		eosio_assert( token_names, "this build keeps no per-token names" );
+		names.emplace( _self, [&]( auto& tkn_name ) {
+			tkn_name.id = old.id;
+			tkn_name.tokenName = old.tokenName;
+		});
+	}
+
+	eosio_assert( token_uris || old.uri.empty(), "this build issues tokens without uris" );
+	// Legacy uris are full uris, a base uri set later must not prefix them
+	token_index tokens( _self, sym.raw() );
+	mint( tokens, old.id, old.owner, _self, old.uri, true );
+	add_batch( old.id, 1, sym, string(), _self );
+
+	return legacy.erase( it );
+}
 
-	sub_balance( payer, st.value );
-	add_balance( payer, st.value, payer );
+symbol_code nft::upgrade_legacy( id_type id ) {
+
+	// A token not migrated yet is converted by the first action
+	// touching it, so it stays usable while migrate runs
+	if( migrated( 1 ) )
+		return symbol_code();
+
+	legacy_token_index legacy( _self, _self.value );
+	auto old = legacy.find( id );
+	if( old == legacy.end() )
+		return symbol_code();
+
+	auto sym = old->value.symbol.code();
+	convert_legacy( legacy, old );
+	return sym;
+}
+
+name nft::legacy_owner_of( id_type id ) {
+
+	if( migrated( 1 ) )
+		return name();
+
+	legacy_token_index legacy( _self, _self.value );
+	auto old = legacy.find( id );
+	return old != legacy.end() ? old->owner : name();
 }
 
+id_type nft::upgrade_legacy_of( name owner, symbol_code sym ) {
+
+	eosio_assert( !migrated( 1 ), "token is not found or is not owned by account" );
+
+	// Any legacy token of the owner with the symbol. Deployed rows only
+	// carry the byowner and bysymbol entries, so walk the owner's tokens
+	legacy_token_index legacy( _self, _self.value );
+	auto byowner = legacy.get_index<"byowner"_n>();
+	auto old = byowner.lower_bound( owner.value );
+	while( old != byowner.end() && old->owner == owner && old->value.symbol.code() != sym )
+		++old;
+	eosio_assert( old != byowner.end() && old->owner == owner, "token is not found or is not owned by account" );
+
+	id_type id = old->id;
+	convert_legacy( legacy, legacy.find( id ) );
+	return id;
+}
 
 ACTION nft::burn( name owner, id_type token_id ) {
 
         require_auth( owner );
 
+	// Remove token and lower balance from owner
+	asset burnt_supply = erase_token( token_id, owner );
+        if( keeps_balances( burnt_supply.symbol.code() ) )
+            sub_balance( owner, burnt_supply );
+
+        // Lower supply from currency
+        sub_supply( burnt_supply );
+}
+
+ACTION nft::burnids( name owner, vector<id_type> ids ) {
+
+        require_auth( owner );
+
+	eosio_assert( !ids.empty(), "no token ids provided" );
+
+	// Amount burnt per symbol, also rejects ids listed twice
+	vector<asset> burnt;
+	for( auto id: ids ) {
+		sum_by_symbol( burnt, erase_token( id, owner ) );
+	}
+
+	// Lower balance and supply once per symbol
+	for( const auto& quantity: burnt ) {
+		if( keeps_balances( quantity.symbol.code() ) )
+			sub_balance( owner, quantity );
+		sub_supply( quantity );
+	}
+}
+
+asset nft::erase_token( id_type id, name owner ) {
+
+	auto sym = symbol_of( id );
+	eosio_assert( sym.raw() != 0, "token with id does not exist" );
+
         // Find token to burn
-        auto burn_token = tokens.find( token_id );
-	eosio_assert( burn_token != tokens.end(), "token with id does not exist" );
+	token_index tokens( _self, sym.raw() );
+        auto burn_token = tokens.find( id );
+	if( burn_token == tokens.end() ) {
+		// Lazily issued token only leaves its range record
+		range_index ranges( _self, sym.raw() );
+		auto range = find_range( ranges, id );
+		if( range == ranges.end() ) {
+			// Content-addressed token
+			hashtoken_index hashed( _self, sym.raw() );
+			const auto& hashed_token = hashed.get( id, "token with id does not exist" );
+			eosio_assert( hashed_token.owner == owner, "token not owned by account" );
+
+			asset value = hashed_token.get_value();
+			hashed.erase( hashed_token );
+			clear_approval( id );
+
+			holding_index holdings( _self, owner.value );
+			holdings.erase( holdings.get( id, "token is missing from owner inventory" ) );
+			log_change( "burn"_n, id, 1, owner, name() );
+			return value;
+		}
+		eosio_assert( range->owner == owner, "token not owned by account" );
+
+		split_range( ranges, range, id, owner );
+		clear_approval( id );
+		log_change( "burn"_n, id, 1, owner, name() );
+		return asset{1, symbol(sym, 0)};
+	}
+
 	eosio_assert( burn_token->owner == owner, "token not owned by account" );
 
-	asset burnt_supply = burn_token->value;
+	asset value = burn_token->get_value();
 
-	// Remove token from tokens table
+	// Remove token from tokens table and owner inventory
         tokens.erase( burn_token );
+	erase_meta( sym, id );
+	erase_name( id );
+	clear_approval( id );
 
-        // Lower balance from owner
-        sub_balance( owner, burnt_supply );
+	holding_index holdings( _self, owner.value );
+	holdings.erase( holdings.get( id, "token is missing from owner inventory" ) );
+	log_change( "burn"_n, id, 1, owner, name() );
 
-        // Lower supply from currency
-        sub_supply( burnt_supply );
+	return value;
+}
+
+
+void nft::erase_name( id_type id ) {
+
+	if constexpr( !token_names )
+		return;
+
+	tokenname_index names( _self, _self.value );
+	auto own_name = names.find( id );
+	if( own_name != names.end() ) {
+		names.erase( own_name );
+	}
+}
+
+void nft::erase_meta( symbol_code sym, id_type id ) {
+
+	if constexpr( !token_uris )
+		return;
+
+	tokenmeta_index metas( _self, sym.raw() );
+	auto meta = metas.find( id );
+	if( meta != metas.end() ) {
+		metas.erase( meta );
+	}
 }
 
+ACTION nft::setlogwindow( uint64_t window ) {
+
+	require_auth( _self );
+
+	changelog_singleton log_table( _self, _self.value );
+	auto log = log_table.get_or_default( changelog{} );
+	log.window = window;
+	log_table.set( log, _self );
+
+	// Drop the changes that left a smaller window, also when the log
+	// is turned off, at most max_query_limit per call
+	change_index changes( _self, _self.value );
+	auto oldest = changes.begin();
+	for( uint64_t n = 0; oldest != changes.end() && oldest->seq + window < log.next_seq; ++n ) {
+		if( n == max_query_limit ) {
+			// Continue with the next call
+			print( "next seq: ", oldest->seq );
+			break;
+		}
+		oldest = changes.erase( oldest );
+	}
+}
+
+void nft::log_change( name op, id_type id, uint64_t count, name from, name to ) {
+
+	changelog_singleton log_table( _self, _self.value );
+	if( !log_table.exists() )
+		return;
+
+	auto log = log_table.get();
+	if( log.window == 0 )
+		return;
+
+	// Rows are paid by the contract, the window bounds their RAM
+	change_index changes( _self, _self.value );
+	changes.emplace( _self, [&]( auto& change ) {
+		change.seq = log.next_seq;
+		change.id = id;
+		change.count = count;
+		change.op = op;
+		change.from = from;
+		change.to = to;
+	});
+
+	// Drop changes that left the window, at most two per write
+	// so a smaller window is caught up with over the next writes
+	for( int i = 0; i < 2; ++i ) {
+		auto oldest = changes.begin();
+		if( oldest->seq + log.window > log.next_seq )
+			break;
+		changes.erase( oldest );
+	}
+
+	log.next_seq++;
+	log_table.set( log, _self );
+}
+
+ACTION nft::ownerof( vector<id_type> ids ) {
+
+	eosio_assert( ids.size() <= max_query_limit, "too many ids in one query" );
+
+	// One line per id, the owner is empty for unknown or burnt ids
+	for( auto id: ids )
+		print( id, " ", owner_of( id ), "\n" );
+}
+
+ACTION nft::tokensof( name owner, symbol_code sym, id_type cursor, uint64_t limit ) {
+
+	eosio_assert( limit > 0, "limit must be positive" );
+	eosio_assert( limit <= max_query_limit, "limit is too large" );
+
+	// Walk the owner's inventory in id order starting at the cursor, with an
+	// empty symbol every symbol is listed. Entries of other symbols count
+	// towards the limit so a call reads at most "limit" entries.
+	holding_index holdings( _self, owner.value );
+	auto it = holdings.lower_bound( cursor );
+
+	// Tokens not migrated yet follow the inventory, a cursor naming
+	// one of them continues there
+	legacy_token_index legacy( _self, _self.value );
+	auto byowner = legacy.get_index<"byowner"_n>();
+	auto old = byowner.end();
+	if( !migrated( 1 ) ) {
+		auto named = legacy.find( cursor );
+		if( named != legacy.end() && named->owner == owner ) {
+			it = holdings.end();
+			old = byowner.iterator_to( *named );
+		} else {
+			old = byowner.lower_bound( owner.value );
+		}
+	}
+
+	uint64_t n = 0;
+	for( ; it != holdings.end() && n < limit; ++n, ++it ) {
+		if( sym.raw() != 0 && it->sym != sym )
+			continue;
+
+		// A token with its own row, a content-addressed token,
+		// or a range of tokens that share the base uri
+		token_index tokens( _self, it->sym.raw() );
+		auto token = tokens.find( it->id );
+		if( token != tokens.end() ) {
+			print( "token: ", it->id, " ", it->sym, " ", token->get_uri( _self ), "\n" );
+			continue;
+		}
+
+		hashtoken_index hashed( _self, it->sym.raw() );
+		auto hashed_token = hashed.find( it->id );
+		if( hashed_token != hashed.end() ) {
+			print( "token: ", it->id, " ", it->sym, " ", hashed_token->get_uri( _self ), "\n" );
+			continue;
+		}
+
+		collection_index collections( _self, _self.value );
+		print( "range: ", it->id, " ", it->count, " ", it->sym, " ", collections.get( it->sym.raw(), "collection does not exist" ).base_uri, "\n" );
+	}
+
+	// Legacy uris are absolute
+	for( ; old != byowner.end() && old->owner == owner && n < limit; ++n, ++old ) {
+		if( sym.raw() != 0 && old->value.symbol.code() != sym )
+			continue;
+
+		print( "token: ", old->id, " ", old->value.symbol.code(), " ", old->uri, "\n" );
+	}
+
+	// Continue with the next call
+	if( it != holdings.end() )
+		print( "next id: ", it->id );
+	else if( old != byowner.end() && old->owner == owner )
+		print( "next id: ", old->id );
+}
+
+ACTION nft::supplyof( vector<symbol_code> symbols ) {
+
+	eosio_assert( symbols.size() <= max_query_limit, "too many symbols in one query" );
+
+	// Supply and issuer, or a zero supply for unknown symbols
+	for( auto sym: symbols ) {
+		currency_index currency_table( _self, sym.raw() );
+		auto existing_currency = currency_table.find( sym.raw() );
+		if( existing_currency == currency_table.end() ) {
+			print( asset{0, symbol(sym, 0)}, "\n" );
+			continue;
+		}
+		print( existing_currency->supply, " ", existing_currency->issuer, "\n" );
+	}
+}
+
+ACTION nft::balanceof( name owner, symbol_code sym, id_type cursor, uint64_t limit ) {
+
+	eosio_assert( sym.is_valid(), "invalid symbol name" );
+	eosio_assert( limit > 0, "limit must be positive" );
+	eosio_assert( limit <= max_query_limit, "limit is too large" );
+
+	// Counted from the owner's inventory, so the answer does not depend
+	// on balance rows. Prints the count of the entries read by this call,
+	// the balance is the sum over all calls.
+	holding_index holdings( _self, owner.value );
+	auto it = holdings.lower_bound( cursor );
+
+	// Tokens not migrated yet follow the inventory, a cursor naming
+	// one of them continues there
+	legacy_token_index legacy( _self, _self.value );
+	auto byowner = legacy.get_index<"byowner"_n>();
+	auto old = byowner.end();
+	if( !migrated( 1 ) ) {
+		auto named = legacy.find( cursor );
+		if( named != legacy.end() && named->owner == owner ) {
+			it = holdings.end();
+			old = byowner.iterator_to( *named );
+		} else {
+			old = byowner.lower_bound( owner.value );
+		}
+	}
+
+	int64_t count = 0;
+	uint64_t n = 0;
+	for( ; it != holdings.end() && n < limit; ++n, ++it ) {
+		if( it->sym == sym )
+			count += it->count;
+	}
+	for( ; old != byowner.end() && old->owner == owner && n < limit; ++n, ++old ) {
+		if( old->value.symbol.code() == sym )
+			count++;
+	}
+	print( asset{count, symbol(sym, 0)}, "\n" );
+
+	// Continue with the next call
+	if( it != holdings.end() )
+		print( "next id: ", it->id );
+	else if( old != byowner.end() && old->owner == owner )
+		print( "next id: ", old->id );
+}
 
 void nft::sub_balance( name owner, asset value ) {
 
@@ -235,7 +1510,7 @@ void nft::sub_balance( name owner, asset value ) {
         if( from.balance.amount == value.amount ) {
             from_acnts.erase( from );
         } else {
-            from_acnts.modify( from, owner, [&]( auto& a ) {
+            from_acnts.modify( from, name(0), [&]( auto& a ) {
                 a.balance -= value;
             });
         }
@@ -256,6 +1531,28 @@ void nft::add_balance( name owner, asset value, name ram_payer ) {
         }
 }
 
+void nft::set_balance_payer( name owner, symbol_code sym, name ram_payer ) {
+
+	if constexpr( !balance_rows )
+		return;
+
+	account_index acnts( _self, owner.value );
+	auto balance = acnts.find( sym.raw() );
+	if( balance != acnts.end() ) {
+		acnts.modify( balance, ram_payer, []( auto& ){} );
+	}
+}
+
+bool nft::keeps_balances( symbol_code sym ) {
+
+	if constexpr( !balance_rows )
+		return false;
+
+	collection_index collections( _self, _self.value );
+	auto existing_collection = collections.find( sym.raw() );
+	return existing_collection == collections.end() || !existing_collection->no_balances;
+}
+
 void nft::sub_supply( asset quantity ) {
 
 	auto symbol_name = quantity.symbol.code().raw();
@@ -278,4 +1575,29 @@ void nft::add_supply( asset quantity ) {
         });
 }
 
-EOSIO_DISPATCH( nft, (create)(issue)(transfer)(transferid)(setrampayer)(burn) )
+void nft::sum_by_symbol( vector<asset>& totals, const asset& value ) {
+
+	auto total = std::find_if( totals.begin(), totals.end(), [&]( const auto& a ) {
+		return a.symbol == value.symbol;
+	});
+
+	if( total == totals.end() ) {
+		totals.push_back( value );
+	} else {
+		*total += value;
+	}
+}
+
+// Actions of features left out of the build are not dispatched
+#if NFT_TOKEN_URIS
+#define NFT_URI_ACTIONS (beginissue)(continueissue)
+#else
+#define NFT_URI_ACTIONS
+#endif
+#if NFT_BALANCES
+#define NFT_BALANCE_ACTIONS (setbalances)
+#else
+#define NFT_BALANCE_ACTIONS
+#endif
+
+EOSIO_DISPATCH( nft, (create)(issue)(issuemany)(issuehash)NFT_URI_ACTIONS(setbaseuri)NFT_BALANCE_ACTIONS(transfer)(transferid)(transferids)(swap)(setapproval)(approveall)(setrampayer)(setrampayers)(migrate)(setlogwindow)(ownerof)(tokensof)(supplyof)(balanceof)(burn)(burnids) )
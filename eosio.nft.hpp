@@ -1,5 +1,6 @@
 #include <eosiolib/eosio.hpp>
 #include <eosiolib/asset.hpp>
+#include <eosiolib/singleton.hpp>
 #include <string>
 #include <vector>
 
@@ -10,12 +11,41 @@ typedef uint128_t uuid;
 typedef uint64_t id_type;
 typedef string uri_type;
 
+// Features of the build, all on by default. The variant targets in
+// CMakeLists.txt turn them off to leave their table work out of the code.
+#ifndef NFT_BALANCES
+#define NFT_BALANCES 1       // balance rows in "accounts"
+#endif
+#ifndef NFT_TOKEN_URIS
+#define NFT_TOKEN_URIS 1     // per-token uri suffixes in "tokenmeta"
+#endif
+#ifndef NFT_TOKEN_NAMES
+#define NFT_TOKEN_NAMES 1    // names of batches and migrated tokens that differ from their collection name
+#endif
+
+// one token moved by a swap
+struct swap_leg {
+    name from;
+    name to;
+    id_type id;
+};
+
+// one token minted by issuemany
+struct issue_leg {
+    name to;
+    uri_type uri;
+};
+
 CONTRACT nft : public eosio::contract {
 
      public:
 	using contract::contract;
+
+	static constexpr bool balance_rows = NFT_BALANCES;
+	static constexpr bool token_uris = NFT_TOKEN_URIS;
+	static constexpr bool token_names = NFT_TOKEN_NAMES;
         nft( name receiver, name code, datastream<const char*> ds)
-		: contract(receiver, code, ds), tokens(receiver, receiver.value) {}
+		: contract(receiver, code, ds) {}
 
 
         ACTION create(name issuer, std::string symbol);
@@ -26,11 +56,42 @@ CONTRACT nft : public eosio::contract {
 		   string name,
                    string memo);
 
+        ACTION issuemany(symbol_code sym,
+                       vector<issue_leg> legs,
+                       string name,
+                       string memo);
+
+        ACTION issuehash(name to,
+                       asset quantity,
+                       vector<checksum256> hashes,
+                       string name,
+                       string memo);
+
+#if NFT_TOKEN_URIS
+        ACTION beginissue(name to,
+                        asset quantity,
+                        string name,
+                        string memo);
+
+        ACTION continueissue(uint64_t job_id, vector<string> uris);
+#endif
+
+        ACTION setbaseuri(symbol_code sym, string base_uri);
+
+#if NFT_BALANCES
+        ACTION setbalances(symbol_code sym, bool keep);
+#endif
+
         ACTION transferid(name from,
                       name to,
                       id_type id,
                       string memo);
 
+        ACTION transferids(name from,
+                       name to,
+                       vector<id_type> ids,
+                       string memo);
+
 	ACTION transfer(name from,
                       name to,
                       asset quantity,
@@ -39,8 +100,37 @@ CONTRACT nft : public eosio::contract {
         ACTION burn(name owner,
                   id_type token_id);
 
+        ACTION burnids(name owner,
+                     vector<id_type> ids);
+
+	ACTION swap(vector<swap_leg> legs, string memo);
+
+	ACTION setapproval(name owner, id_type id, name spender);
+
+	ACTION approveall(name owner, name spender, bool approved);
+
 	ACTION setrampayer(name payer, id_type id);
 
+	ACTION setrampayers(name payer, symbol_code sym, id_type cursor, uint64_t limit);
+
+	ACTION migrate(uint64_t limit);
+
+	ACTION setlogwindow(uint64_t window);
+
+	// queries, results are printed to the console
+	ACTION ownerof(vector<id_type> ids);
+
+	ACTION tokensof(name owner, symbol_code sym, id_type cursor, uint64_t limit);
+
+	ACTION supplyof(vector<symbol_code> symbols);
+
+	ACTION balanceof(name owner, symbol_code sym, id_type cursor, uint64_t limit);
+
+	// name of a token, joined from its batch or collection row
+	string get_name(id_type id);
+
+	string get_unique_name(id_type id);
+
 
         TABLE account {
 
@@ -59,19 +149,55 @@ CONTRACT nft : public eosio::contract {
         };
 
 
+        TABLE collection {
+            symbol_code sym;     // collection symbol
+	    string tokenName;	 // name shared by every token of the symbol
+	    string base_uri;	 // prefix of every non-absolute token uri of the symbol
+	    bool no_balances;	 // balances are not kept in "accounts"
+
+            uint64_t primary_key() const { return sym.raw(); }
+        };
+
+
+        // name of a token migrated from the legacy layout
+        // whose name differs from its collection and batch name
+        TABLE tokenname {
+            id_type id;
+	    string tokenName;
+
+            id_type primary_key() const { return id; }
+        };
+
+
+        // fixed size row, the only one written by transfers,
+        // burns and payer changes
         TABLE token {
             id_type id;          // Unique 64 bit identifier,
-            uri_type uri;        // RFC 3986
             name owner;  	 // token owner
-            asset value;         // token value (1 SYS)
-	    string tokenName;	 // token name
+            symbol_code sym;     // token symbol, value is always 1 of it
 
             id_type primary_key() const { return id; }
             uint64_t get_owner() const { return owner.value; }
-            string get_uri() const { return uri; }
-            asset get_value() const { return value; }
-	    uint64_t get_symbol() const { return value.symbol.code().raw(); }
-	    string get_name() const { return tokenName; }
+            asset get_value() const { return asset{1, symbol(sym, 0)}; }
+	    uint64_t get_symbol() const { return sym.raw(); }
+
+	    // collection base uri followed by the stored suffix, the stored
+	    // uri alone when it is absolute, or the base uri followed by the
+	    // token id when the token was issued without uri
+	    string get_uri(name self) const
+	    {
+		collection_index collections( self, self.value );
+		auto existing = collections.find( get_symbol() );
+		string base = existing != collections.end() ? existing->base_uri : string();
+
+		if constexpr( token_uris ) {
+			tokenmeta_index metas( self, get_symbol() );
+			auto meta = metas.find( id );
+			if( meta != metas.end() )
+				return meta->absolute ? meta->uri : base + meta->uri;
+		}
+		return base.empty() ? base : base + std::to_string(id);
+	    }
 
 	    // generated token global uuid based on token id and
 	    // contract name, passed in the argument
@@ -82,30 +208,263 @@ CONTRACT nft : public eosio::contract {
 		uint128_t res = (self_128 << 64) | (id_128);
 		return res;
 	    }
+        };
+
+
+        // token metadata, written at mint and never by ownership
+        // changes, tokens issued without uri have no row
+        TABLE tokenmeta {
+            id_type id;
+            uri_type uri;        // RFC 3986, appended to the collection base uri
+            bool absolute;       // issued before the collection had a base uri, used as is
+
+            id_type primary_key() const { return id; }
+        };
+
+
+        // tokens issued without uris, each token of the range gets its
+        // own row the first time it is transferred or its RAM payer changes
+        TABLE range {
+            id_type start;       // id of the first token
+            uint64_t count;      // number of tokens
+            name owner;  	 // owner of every token in the range
+            symbol_code sym;     // symbol of every token in the range
+
+            id_type primary_key() const { return start; }
+            uint64_t get_owner() const { return owner.value; }
+        };
+
+
+        // content-addressed token, only the fixed size hash is stored
+        // and the uri is rebuilt from the collection base uri
+        TABLE hashtoken {
+            id_type id;
+            checksum256 content_hash;    // e.g. sha256 of an IPFS or Arweave object
+            name owner;
+            symbol_code sym;
 
-	    string get_unique_name() const
+            id_type primary_key() const { return id; }
+            uint64_t get_owner() const { return owner.value; }
+            checksum256 get_hash() const { return content_hash; }
+            asset get_value() const { return asset{1, symbol(sym, 0)}; }
+
+	    // base uri with "{hash}" replaced by the hex hash,
+	    // or followed by it when the base has no placeholder
+	    string get_uri(name self) const
 	    {
-		string unique_name = tokenName + "#" + std::to_string(id);
-		return unique_name;
+		static const char* digits = "0123456789abcdef";
+		string hex;
+		for( auto b: content_hash.extract_as_byte_array() ) {
+			hex += digits[b >> 4];
+			hex += digits[b & 0x0f];
+		}
+
+		collection_index collections( self, self.value );
+		string base = collections.get( sym.raw(), "collection does not exist" ).base_uri;
+		auto pos = base.find( "{hash}" );
+		if( pos == string::npos )
+			return base + hex;
+		return base.replace( pos, 6, hex );
 	    }
         };
 
+
+        // owner inventory entry, a single token or a range
+        // of tokens issued without uris, scoped by owner. The uri
+        // is not copied, sym and id are the key of its "tokenmeta"
+        // or "hashtokens" row, without either it is the collection
+        // base uri followed by the id
+        TABLE holding {
+            id_type id;          // token id, or first id of a range
+            uint64_t count;      // 1 for a token, range size otherwise
+            symbol_code sym;     // token symbol
+
+            id_type primary_key() const { return id; }
+        };
+
+
+        // id -> symbol directory, one record per run of
+        // consecutive ids issued with the same symbol
+        TABLE batch {
+            id_type start;       // id of the first token
+            uint64_t count;      // number of ids
+            symbol_code sym;     // symbol of every token in the batch
+            string tokenName;    // name of every token in the batch when it
+                                 // differs from the collection name, else empty
+
+            id_type primary_key() const { return start; }
+        };
+
+
+        TABLE global {
+            id_type next_id;     // id of the next issued token
+        };
+
+
+        // account allowed to transfer one token for its owner
+        TABLE approval {
+            id_type id;
+            name spender;
+
+            id_type primary_key() const { return id; }
+        };
+
+
+        // account allowed to transfer every token of an owner,
+        // scoped by owner
+        TABLE opapproval {
+            name spender;
+
+            uint64_t primary_key() const { return spender.value; }
+        };
+
+
+        // token change for off-chain indexers, the last
+        // "window" changes are kept
+        TABLE change {
+            uint64_t seq;        // sequence number, grows by 1 per change
+            id_type id;          // token id, or first id of a minted batch
+            uint64_t count;      // 1, or number of tokens minted or rebilled as a range
+            name op;             // mint, transfer, burn or rampayer
+            name from;           // previous owner, empty for mint
+            name to;             // new owner, empty for burn
+
+            uint64_t primary_key() const { return seq; }
+        };
+
+
+        TABLE changelog {
+            uint64_t next_seq;   // sequence number of the next change
+            uint64_t window;     // number of changes kept, 0 disables the log
+        };
+
+
+        // progress of the schema migration run by migrate
+        TABLE migration {
+            uint32_t version;    // schema version every stored row has reached
+            uint64_t cursor;     // primary key the current step continues from
+        };
+
+
+        // issuance spread over several continueissue calls
+        TABLE issuejob {
+            uint64_t id;
+            name to;             // receiver of every token
+            asset quantity;      // total number of tokens
+            uint64_t issued;     // tokens minted so far
+            string tokenName;    // name of the job's tokens, empty for the collection name
+
+            uint64_t primary_key() const { return id; }
+        };
+
+
+        // token layout before names moved to the collection row, schema
+        // version 0. Read by migrate and by actions touching a token
+        // that is not migrated yet.
+        TABLE legacy_token {
+            id_type id;
+            uri_type uri;
+            name owner;
+            asset value;
+	    string tokenName;
+
+            id_type primary_key() const { return id; }
+            uint64_t get_owner() const { return owner.value; }
+	    uint64_t get_symbol() const { return value.symbol.code().raw(); }
+        };
+
 	using account_index = eosio::multi_index<"accounts"_n, account>;
 
 	using currency_index = eosio::multi_index<"stat"_n, stats,
 	                       indexed_by< "byissuer"_n, const_mem_fun< stats, uint64_t, &stats::get_issuer> > >;
 
-	using token_index = eosio::multi_index<"token"_n, token,
-	                    indexed_by< "byowner"_n, const_mem_fun< token, uint64_t, &token::get_owner> >,
-			    indexed_by< "bysymbol"_n, const_mem_fun< token, uint64_t, &token::get_symbol> > >;
+	using collection_index = eosio::multi_index<"collection"_n, collection>;
+
+	using tokenname_index = eosio::multi_index<"tokennames"_n, tokenname>;
+
+	// token and range tables are scoped by symbol code
+	using token_index = eosio::multi_index<"tokens"_n, token,
+	                    indexed_by< "byowner"_n, const_mem_fun< token, uint64_t, &token::get_owner> > >;
+
+	using tokenmeta_index = eosio::multi_index<"tokenmeta"_n, tokenmeta>;
+
+	using range_index = eosio::multi_index<"ranges"_n, range,
+	                    indexed_by< "byowner"_n, const_mem_fun< range, uint64_t, &range::get_owner> > >;
+
+	using hashtoken_index = eosio::multi_index<"hashtokens"_n, hashtoken,
+	                        indexed_by< "byowner"_n, const_mem_fun< hashtoken, uint64_t, &hashtoken::get_owner> >,
+	                        indexed_by< "byhash"_n, const_mem_fun< hashtoken, checksum256, &hashtoken::get_hash> > >;
+
+	using batch_index = eosio::multi_index<"batches"_n, batch>;
+
+	using holding_index = eosio::multi_index<"inventory"_n, holding>;
+
+	using global_singleton = eosio::singleton<"global"_n, global>;
+
+	using change_index = eosio::multi_index<"changes"_n, change>;
+
+	using changelog_singleton = eosio::singleton<"changelog"_n, changelog>;
+
+	using migration_singleton = eosio::singleton<"migration"_n, migration>;
+
+	using issuejob_index = eosio::multi_index<"issuejobs"_n, issuejob>;
+
+	using approval_index = eosio::multi_index<"approvals"_n, approval>;
+
+	using operator_index = eosio::multi_index<"operators"_n, opapproval>;
+
+	using legacy_token_index = eosio::multi_index<"token"_n, legacy_token,
+	                    indexed_by< "byowner"_n, const_mem_fun< legacy_token, uint64_t, &legacy_token::get_owner> >,
+			    indexed_by< "bysymbol"_n, const_mem_fun< legacy_token, uint64_t, &legacy_token::get_symbol> > >;
 
     private:
-	token_index tokens;
+        // most ids, symbols or inventory entries read by one query
+        static constexpr uint64_t max_query_limit = 100;
+
+        // most operators an owner may approve, transfers check each
+        static constexpr uint64_t max_operators = 16;
+
+        // schema version written by this code, each migrate step
+        // converts the rows of one version to the next
+        static constexpr uint32_t schema_version = 1;
 
-        void mint(name owner, name ram_payer, asset value, string uri, string name);
+        collection_index::const_iterator set_collection_name(collection_index& collections, const stats& st, const string& tkn_name);
+        void mint_batch(name to, asset quantity, const vector<string>& uris, const vector<checksum256>& hashes, const string& tkn_name, name issuer);
+        id_type reserve_ids(uint64_t count);
+        string batch_name(collection_index::const_iterator collection, const string& tkn_name);
+        void add_batch(id_type start, uint64_t count, symbol_code sym, const string& tkn_name, name ram_payer);
+        symbol_code symbol_of(id_type id);
+        symbol_code batch_symbol_of(id_type id);
+        void mint(token_index& tokens, id_type id, name owner, name ram_payer, string uri, bool absolute);
+        void add_holding(name owner, id_type id, uint64_t count, symbol_code sym, name ram_payer);
+        void move_holding(name from, name to, id_type id, name ram_payer);
+
+        range_index::const_iterator find_range(range_index& ranges, id_type id);
+        void split_range(range_index& ranges, range_index::const_iterator range, id_type id, name ram_payer);
+        token_index::const_iterator materialize(token_index& tokens, id_type id, name ram_payer);
+        asset move_token(token_index& tokens, name from, name to, id_type id, name ram_payer);
+        asset move_hashed_token(symbol_code sym, name from, name to, id_type id, name ram_payer);
+        name transfer_authority(name from, id_type id);
+        name owner_of(id_type id);
+        void clear_approval(id_type id);
+        asset erase_token(id_type id, name owner);
+        void erase_name(id_type id);
+        void erase_meta(symbol_code sym, id_type id);
+        void log_change(name op, id_type id, uint64_t count, name from, name to);
+
+        bool migrated(uint32_t version);
+        bool migrate_step(uint32_t version, uint64_t& cursor, uint64_t& budget);
+        legacy_token_index::const_iterator convert_legacy(legacy_token_index& legacy, legacy_token_index::const_iterator it);
+        symbol_code upgrade_legacy(id_type id);
+        name legacy_owner_of(id_type id);
+        id_type upgrade_legacy_of(name owner, symbol_code sym);
 
         void sub_balance(name owner, asset value);
         void add_balance(name owner, asset value, name ram_payer);
+        void set_balance_payer(name owner, symbol_code sym, name ram_payer);
+        bool keeps_balances(symbol_code sym);
         void sub_supply(asset quantity);
         void add_supply(asset quantity);
+
+        static void sum_by_symbol(vector<asset>& totals, const asset& value);
 };
@@ -0,0 +1,165 @@
+/**
+ *  Minimal Google Benchmark style harness.
+ *
+ *  Benchmarks are plain functions taking a `state&` and looping over it:
+ *
+ *     static void BM_transfer( nftbench::state& st ) {
+ *        setup( st.range(0) );
+ *        for( auto _ : st ) { ... }
+ *     }
+ *     BENCHMARK( BM_transfer )->Arg( 1000 )->Arg( 100000 );
+ *
+ *  Each benchmark is rerun with a growing iteration count until it takes at
+ *  least --min_time seconds, then reported as time per iteration.
+ */
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace nftbench {
+
+   class state {
+      public:
+         typedef std::chrono::steady_clock clock;
+
+         state( uint64_t iterations, std::vector<int64_t> args )
+            : _iterations(iterations), _args(std::move(args)) {}
+
+         class iterator {
+            public:
+               iterator( state* st, uint64_t left ) : _st(st), _left(left) {}
+               bool operator!=( const iterator& ) const {
+                  if( _left != 0 ) return true;
+                  _st->finish();
+                  return false;
+               }
+               iterator& operator++() { --_left; return *this; }
+               int operator*() const { return 0; }
+            private:
+               state*   _st;
+               uint64_t _left;
+         };
+
+         iterator begin() { start(); return iterator( this, _iterations ); }
+         iterator end() { return iterator( this, 0 ); }
+
+         /// Excludes per-iteration setup from the measured time.
+         void pause_timing() { _elapsed += clock::now() - _started; }
+         void resume_timing() { _started = clock::now(); }
+
+         int64_t range( size_t i = 0 ) const { return _args.at( i ); }
+         uint64_t iterations() const { return _iterations; }
+
+         /// Items per second are reported when set, e.g. tokens minted.
+         void set_items_processed( uint64_t items ) { _items = items; }
+
+         double seconds() const { return std::chrono::duration<double>( _elapsed ).count(); }
+         uint64_t items() const { return _items; }
+
+      private:
+         void start() { _elapsed = clock::duration::zero(); _started = clock::now(); }
+         void finish() { _elapsed += clock::now() - _started; }
+
+         uint64_t             _iterations;
+         std::vector<int64_t> _args;
+         uint64_t             _items = 0;
+         clock::time_point    _started;
+         clock::duration      _elapsed = clock::duration::zero();
+   };
+
+   class benchmark {
+      public:
+         benchmark( std::string name, std::function<void(state&)> fn ) : _name(std::move(name)), _fn(std::move(fn)) {}
+
+         benchmark* Arg( int64_t arg ) { _args.push_back( { arg } ); return this; }
+
+         const std::string& name() const { return _name; }
+         const std::vector<std::vector<int64_t>>& args() const { return _args; }
+         void run( state& st ) const { _fn( st ); }
+
+      private:
+         std::string                       _name;
+         std::function<void(state&)>       _fn;
+         std::vector<std::vector<int64_t>> _args;
+   };
+
+   inline std::vector<std::unique_ptr<benchmark>>& registry() {
+      static std::vector<std::unique_ptr<benchmark>> benchmarks;
+      return benchmarks;
+   }
+
+   inline benchmark* register_benchmark( const char* name, void (*fn)(state&) ) {
+      registry().emplace_back( new benchmark( name, fn ) );
+      return registry().back().get();
+   }
+
+   /// Options: --filter=<regex>, --min_time=<seconds>, --iterations=<fixed count>
+   inline int run_all( int argc, char** argv ) {
+      std::regex filter( ".*" );
+      double min_time = 0.5;
+      uint64_t fixed_iterations = 0;
+
+      for( int i = 1; i < argc; ++i ) {
+         std::string arg = argv[i];
+         if( arg.rfind( "--filter=", 0 ) == 0 )
+            filter = std::regex( arg.substr( 9 ) );
+         else if( arg.rfind( "--min_time=", 0 ) == 0 )
+            min_time = std::stod( arg.substr( 11 ) );
+         else if( arg.rfind( "--iterations=", 0 ) == 0 )
+            fixed_iterations = std::stoull( arg.substr( 13 ) );
+         else {
+            std::fprintf( stderr, "usage: %s [--filter=<regex>] [--min_time=<seconds>] [--iterations=<n>]\n", argv[0] );
+            return 1;
+         }
+      }
+
+      std::printf( "%-40s %14s %12s %16s\n", "Benchmark", "Time/iter", "Iterations", "Items/s" );
+      for( const auto& bm : registry() ) {
+         auto args = bm->args();
+         if( args.empty() ) args.push_back( {} );
+
+         for( const auto& a : args ) {
+            std::string name = bm->name();
+            for( auto v : a ) name += "/" + std::to_string( v );
+            if( !std::regex_search( name, filter ) ) continue;
+
+            // Grow the iteration count until the run is long enough to trust
+            uint64_t iterations = fixed_iterations ? fixed_iterations : 1;
+            for( ;; ) {
+               state st( iterations, a );
+               bm->run( st );
+
+               if( fixed_iterations || st.seconds() >= min_time || iterations >= 1000000000 ) {
+                  double ns = st.seconds() * 1e9 / iterations;
+                  std::string items = st.items() && st.seconds() > 0
+                                    ? std::to_string( uint64_t( st.items() / st.seconds() ) ) : "";
+                  std::printf( "%-40s %11.0f ns %12llu %16s\n", name.c_str(), ns,
+                               (unsigned long long)iterations, items.c_str() );
+                  break;
+               }
+
+               double grow = st.seconds() > 0 ? 1.4 * min_time / st.seconds() : 10;
+               iterations = std::max<uint64_t>( iterations + 1, uint64_t( iterations * std::min( grow, 10.0 ) ) );
+            }
+         }
+      }
+      return 0;
+   }
+
+} // namespace nftbench
+
+#define NFTBENCH_CONCAT2( a, b ) a##b
+#define NFTBENCH_CONCAT( a, b ) NFTBENCH_CONCAT2( a, b )
+
+#define BENCHMARK( fn ) \
+   static ::nftbench::benchmark* NFTBENCH_CONCAT( nftbench_registered_, __LINE__ ) = \
+      ::nftbench::register_benchmark( #fn, fn )
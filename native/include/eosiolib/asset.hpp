@@ -0,0 +1,136 @@
+/**
+ *  Host stand-in for eosiolib/asset.hpp (symbol_code, symbol, asset).
+ */
+#pragma once
+
+#include <eosiolib/eosio.hpp>
+
+namespace eosio {
+
+   class symbol_code {
+      public:
+         constexpr symbol_code() : value(0) {}
+         constexpr explicit symbol_code( uint64_t raw ) : value(raw) {}
+         constexpr explicit symbol_code( std::string_view str ) : value(0) {
+            if( str.size() > 7 ) throw eosio_assert_failure( "string is too long to be a valid symbol_code" );
+            for( auto itr = str.rbegin(); itr != str.rend(); ++itr ) {
+               if( *itr < 'A' || *itr > 'Z' ) throw eosio_assert_failure( "only uppercase letters allowed in symbol_code string" );
+               value <<= 8;
+               value |= *itr;
+            }
+         }
+
+         constexpr bool is_valid() const {
+            auto sym = value;
+            for( int i = 0; i < 7; i++ ) {
+               char c = (char)(sym & 0xFF);
+               if( !('A' <= c && c <= 'Z') ) return false;
+               sym >>= 8;
+               if( !(sym & 0xFF) ) {
+                  do {
+                     sym >>= 8;
+                     if( (sym & 0xFF) ) return false;
+                     i++;
+                  } while( i < 7 );
+               }
+            }
+            return true;
+         }
+
+         constexpr uint64_t raw() const { return value; }
+         constexpr explicit operator bool() const { return value != 0; }
+
+         std::string to_string() const {
+            std::string s;
+            auto sym = value;
+            while( sym & 0xFF ) {
+               s += char(sym & 0xFF);
+               sym >>= 8;
+            }
+            return s;
+         }
+         void print() const {}
+
+         friend constexpr bool operator==( const symbol_code& a, const symbol_code& b ) { return a.value == b.value; }
+         friend constexpr bool operator!=( const symbol_code& a, const symbol_code& b ) { return a.value != b.value; }
+         friend constexpr bool operator<( const symbol_code& a, const symbol_code& b ) { return a.value < b.value; }
+
+      private:
+         uint64_t value;
+   };
+
+   class symbol {
+      public:
+         constexpr symbol() : value(0) {}
+         constexpr explicit symbol( uint64_t s ) : value(s) {}
+         constexpr symbol( symbol_code sc, uint8_t precision ) : value( (sc.raw() << 8) | (uint64_t)precision ) {}
+         constexpr symbol( std::string_view ss, uint8_t precision ) : value( (symbol_code(ss).raw() << 8) | (uint64_t)precision ) {}
+
+         constexpr bool is_valid() const { return code().is_valid(); }
+         constexpr uint8_t precision() const { return value & 0xFF; }
+         constexpr symbol_code code() const { return symbol_code{value >> 8}; }
+         constexpr uint64_t raw() const { return value; }
+         constexpr explicit operator bool() const { return value != 0; }
+
+         std::string to_string() const { return std::to_string( precision() ) + "," + code().to_string(); }
+         void print() const {}
+
+         friend constexpr bool operator==( const symbol& a, const symbol& b ) { return a.value == b.value; }
+         friend constexpr bool operator!=( const symbol& a, const symbol& b ) { return a.value != b.value; }
+         friend constexpr bool operator<( const symbol& a, const symbol& b ) { return a.value < b.value; }
+
+      private:
+         uint64_t value;
+   };
+
+   struct asset {
+      int64_t amount = 0;
+      eosio::symbol symbol;
+
+      static constexpr int64_t max_amount = (1LL << 62) - 1;
+
+      asset() {}
+      asset( int64_t a, class symbol s ) : amount(a), symbol{s} {
+         eosio_assert( is_amount_within_range(), "magnitude of asset amount must be less than 2^62" );
+         eosio_assert( symbol.is_valid(), "invalid symbol name" );
+      }
+
+      bool is_amount_within_range() const { return -max_amount <= amount && amount <= max_amount; }
+      bool is_valid() const { return is_amount_within_range() && symbol.is_valid(); }
+
+      asset operator-() const { asset r = *this; r.amount = -r.amount; return r; }
+
+      asset& operator-=( const asset& a ) {
+         eosio_assert( a.symbol == symbol, "attempt to subtract asset with different symbol" );
+         amount -= a.amount;
+         eosio_assert( -max_amount <= amount, "subtraction underflow" );
+         eosio_assert( amount <= max_amount, "subtraction overflow" );
+         return *this;
+      }
+
+      asset& operator+=( const asset& a ) {
+         eosio_assert( a.symbol == symbol, "attempt to add asset with different symbol" );
+         amount += a.amount;
+         eosio_assert( -max_amount <= amount, "addition underflow" );
+         eosio_assert( amount <= max_amount, "addition overflow" );
+         return *this;
+      }
+
+      friend asset operator+( const asset& a, const asset& b ) { asset r = a; r += b; return r; }
+      friend asset operator-( const asset& a, const asset& b ) { asset r = a; r -= b; return r; }
+
+      friend bool operator==( const asset& a, const asset& b ) {
+         eosio_assert( a.symbol == b.symbol, "comparison of assets with different symbols is not allowed" );
+         return a.amount == b.amount;
+      }
+      friend bool operator!=( const asset& a, const asset& b ) { return !( a == b ); }
+      friend bool operator<( const asset& a, const asset& b ) {
+         eosio_assert( a.symbol == b.symbol, "comparison of assets with different symbols is not allowed" );
+         return a.amount < b.amount;
+      }
+
+      std::string to_string() const { return std::to_string( amount ) + " " + symbol.code().to_string(); }
+      void print() const {}
+   };
+
+} // namespace eosio
@@ -0,0 +1,265 @@
+/**
+ *  Host stand-in for eosiolib/eosio.hpp.
+ *
+ *  Provides just enough of the eosio.cdt contract API for eosio.nft.cpp to
+ *  compile natively: names, contract base class, authorization and
+ *  notification intrinsics, inline actions and console printing.  State lives
+ *  in process memory (see host_state) so the contract can be driven directly
+ *  from a benchmark or profiler.
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+typedef unsigned __int128 uint128_t;
+typedef __int128 int128_t;
+
+struct eosio_assert_failure : std::runtime_error {
+   using std::runtime_error::runtime_error;
+};
+
+inline void eosio_assert( bool test, const char* msg ) {
+   if( !test ) throw eosio_assert_failure( msg );
+}
+
+namespace eosio {
+
+   struct name {
+      enum class raw : uint64_t {};
+
+      constexpr name() : value(0) {}
+      constexpr explicit name( uint64_t v ) : value(v) {}
+      constexpr name( raw r ) : value(static_cast<uint64_t>(r)) {}
+      constexpr explicit name( std::string_view str ) : value(0) {
+         eosio_assert_constexpr( str.size() <= 13, "string is too long to be a valid name" );
+         auto n = std::min( str.size(), size_t(12) );
+         for( size_t i = 0; i < n; ++i ) {
+            value <<= 5;
+            value |= char_to_value( str[i] );
+         }
+         value <<= ( 4 + 5*(12 - n) );
+         if( str.size() == 13 )
+            value |= char_to_value( str[12] ) & 0x0F;
+      }
+
+      static constexpr uint8_t char_to_value( char c ) {
+         if( c == '.' ) return 0;
+         if( c >= '1' && c <= '5' ) return (c - '1') + 1;
+         if( c >= 'a' && c <= 'z' ) return (c - 'a') + 6;
+         eosio_assert_constexpr( false, "character is not in allowed character set for names" );
+         return 0;
+      }
+
+      static constexpr void eosio_assert_constexpr( bool test, const char* msg ) {
+         if( !test ) throw eosio_assert_failure( msg );
+      }
+
+      constexpr operator raw() const { return raw(value); }
+      constexpr explicit operator bool() const { return value != 0; }
+
+      std::string to_string() const {
+         static const char* charmap = ".12345abcdefghijklmnopqrstuvwxyz";
+         std::string str( 13, '.' );
+         uint64_t tmp = value;
+         for( uint32_t i = 0; i <= 12; ++i ) {
+            char c = charmap[tmp & (i == 0 ? 0x0f : 0x1f)];
+            str[12-i] = c;
+            tmp >>= (i == 0 ? 4 : 5);
+         }
+         auto last = str.find_last_not_of( '.' );
+         return last == std::string::npos ? std::string() : str.substr( 0, last + 1 );
+      }
+
+      friend constexpr bool operator==( const name& a, const name& b ) { return a.value == b.value; }
+      friend constexpr bool operator!=( const name& a, const name& b ) { return a.value != b.value; }
+      friend constexpr bool operator<( const name& a, const name& b ) { return a.value < b.value; }
+
+      uint64_t value;
+   };
+
+   namespace detail {
+      template<char... Str>
+      struct to_const_char_arr {
+         static constexpr const char value[] = {Str...};
+      };
+   }
+
+   template<typename T, T... Str>
+   constexpr name operator""_n() {
+      return name( std::string_view{ detail::to_const_char_arr<Str...>::value, sizeof...(Str) } );
+   }
+
+   struct permission_level {
+      name actor;
+      name permission;
+   };
+
+   template<typename T>
+   class datastream;
+
+   template<>
+   class datastream<const char*> {
+      public:
+         datastream( const char* start = nullptr, size_t s = 0 ) : _start(start), _pos(start), _end(start + s) {}
+      private:
+         const char* _start;
+         const char* _pos;
+         const char* _end;
+   };
+
+   /**
+    *  In-process chain state shared by every stand-in primitive: which
+    *  accounts exist, which authorizations the current action carries, who
+    *  was notified, queued inline actions and registered tables.
+    */
+   struct host_state {
+      std::set<uint64_t>                    accounts;
+      std::set<uint64_t>                    auths;
+      std::vector<name>                     recipients;
+      std::vector<std::function<void()>>    inline_actions;
+      std::vector<std::function<void()>>    table_resets;
+      std::vector<std::function<std::function<void()>()>> table_snapshots;
+      std::ostringstream                    console;
+
+      void create_account( name n ) { accounts.insert( n.value ); }
+
+      /// Drops every table row, account and pending action.
+      void reset() {
+         for( auto& r : table_resets ) r();
+         accounts.clear();
+         auths.clear();
+         recipients.clear();
+         inline_actions.clear();
+         console.str( std::string() );
+      }
+
+      /// Runs one action as if it were pushed in its own transaction signed
+      /// by `signers`, then runs every inline action it queued.  When
+      /// `rollback` is set, all tables are restored if an assertion fires.
+      template<typename F>
+      void apply( std::initializer_list<name> signers, F&& f, bool rollback = false ) {
+         std::vector<std::function<void()>> restores;
+         if( rollback )
+            for( auto& s : table_snapshots ) restores.push_back( s() );
+         try {
+            auths.clear();
+            for( auto s : signers ) auths.insert( s.value );
+            recipients.clear();
+            f();
+            while( !inline_actions.empty() ) {
+               auto next = std::move( inline_actions.front() );
+               inline_actions.erase( inline_actions.begin() );
+               next();
+            }
+         } catch( ... ) {
+            inline_actions.clear();
+            for( auto& r : restores ) r();
+            throw;
+         }
+      }
+   };
+
+   inline host_state& host() {
+      static host_state state;
+      return state;
+   }
+
+   inline bool has_auth( name n ) { return host().auths.count( n.value ) != 0; }
+
+   inline void require_auth( name n ) {
+      eosio_assert( has_auth( n ), ("missing authority of " + n.to_string()).c_str() );
+   }
+
+   inline bool is_account( name n ) { return host().accounts.count( n.value ) != 0; }
+
+   inline void require_recipient( name n ) {
+      for( const auto& r : host().recipients )
+         if( r == n ) return;
+      host().recipients.push_back( n );
+   }
+
+   template<typename... Names>
+   void require_recipient( name n, Names... more ) {
+      require_recipient( n );
+      require_recipient( more... );
+   }
+
+   inline void print_one( std::ostream& os, const name& n ) { os << n.to_string(); }
+   inline void print_one( std::ostream& os, uint128_t v ) {
+      std::string s;
+      do { s.insert( s.begin(), char('0' + int(v % 10)) ); v /= 10; } while( v );
+      os << s;
+   }
+   template<typename T>
+   auto print_one( std::ostream& os, const T& v ) -> decltype( os << v, void() ) { os << v; }
+   template<typename T>
+   auto print_one( std::ostream& os, const T& v ) -> decltype( v.print(), void() ) { os << v.to_string(); }
+
+   template<typename... Args>
+   void print( Args&&... args ) {
+      ( print_one( host().console, args ), ... );
+   }
+
+   class contract {
+      public:
+         contract( name receiver, name code, datastream<const char*> ds )
+            : _self(receiver), _code(code), _ds(ds) {}
+
+         inline name get_self() const { return _self; }
+         inline name get_code() const { return _code; }
+         inline datastream<const char*>& get_datastream() { return _ds; }
+
+      protected:
+         name _self;
+         name _code;
+         datastream<const char*> _ds;
+   };
+
+   namespace detail {
+      template<typename C, typename... Args>
+      struct inline_sender {
+         const C& contract;
+         void (C::*act)(Args...);
+
+         void send( permission_level perm, std::tuple<std::decay_t<Args>...> args ) const {
+            name self = contract.get_self();
+            auto fn = act;
+            host().inline_actions.push_back( [self, fn, perm, args]() {
+               host().auths.clear();
+               host().auths.insert( perm.actor.value );
+               C receiver( self, self, datastream<const char*>() );
+               std::apply( [&]( const auto&... a ) { (receiver.*fn)( a... ); }, args );
+            } );
+         }
+      };
+
+      template<typename C, typename... Args>
+      inline_sender<C, Args...> make_inline_sender( const C& c, void (C::*act)(Args...) ) {
+         return { c, act };
+      }
+   }
+
+} // namespace eosio
+
+#define CONTRACT class
+#define ACTION void
+#define TABLE struct
+
+#define SEND_INLINE_ACTION( CONTRACT, NAME, ... ) \
+   ::eosio::detail::make_inline_sender( CONTRACT, &std::decay_t<decltype(CONTRACT)>::NAME ).send( __VA_ARGS__ )
+
+#define EOSIO_DISPATCH( TYPE, MEMBERS )
+
+#include <eosiolib/multi_index.hpp>
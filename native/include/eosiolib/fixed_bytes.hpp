@@ -0,0 +1,30 @@
+/**
+ *  Host stand-in for eosiolib/fixed_bytes.hpp, only the byte array form of
+ *  fixed_bytes that the contract uses for checksum256.
+ */
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace eosio {
+
+   template<size_t Size>
+   class fixed_bytes {
+      public:
+         fixed_bytes() : _data() {}
+         fixed_bytes( const std::array<uint8_t, Size>& arr ) : _data( arr ) {}
+
+         std::array<uint8_t, Size> extract_as_byte_array() const { return _data; }
+
+         friend bool operator==( const fixed_bytes& a, const fixed_bytes& b ) { return a._data == b._data; }
+         friend bool operator!=( const fixed_bytes& a, const fixed_bytes& b ) { return a._data != b._data; }
+         friend bool operator<( const fixed_bytes& a, const fixed_bytes& b ) { return a._data < b._data; }
+
+      private:
+         std::array<uint8_t, Size> _data;
+   };
+
+   typedef fixed_bytes<32> checksum256;
+
+} // namespace eosio
@@ -0,0 +1,314 @@
+/**
+ *  Host stand-in for eosiolib/multi_index.hpp.
+ *
+ *  Each (code, scope, table) triple is an ordered map from primary key to
+ *  row, and each secondary index is an ordered set of (key, primary key)
+ *  pairs, so lookups and iteration have the same complexity and ordering as
+ *  on chain.  Rows record their RAM payer; emplace/modify enforce the same
+ *  "payer must have authorized" rule nodeos applies.
+ */
+#pragma once
+
+#include <eosiolib/eosio.hpp>
+#include <eosiolib/fixed_bytes.hpp>
+
+#include <limits>
+#include <map>
+#include <memory>
+
+namespace eosio {
+
+   template<name::raw IndexName, typename Extractor>
+   struct indexed_by {
+      static constexpr uint64_t index_name = static_cast<uint64_t>(IndexName);
+      typedef Extractor secondary_extractor_type;
+   };
+
+   template<class Class, typename Type, Type (Class::*PtrToMemberFunction)() const>
+   struct const_mem_fun {
+      typedef typename std::remove_reference<Type>::type result_type;
+      Type operator()( const Class& x ) const { return (x.*PtrToMemberFunction)(); }
+   };
+
+   namespace detail {
+      inline void check_ram_payer( name self, name payer ) {
+         eosio_assert( payer.value == 0 || payer == self || has_auth( payer ),
+                       ("unauthorized RAM usage increase for " + payer.to_string()).c_str() );
+      }
+
+      template<typename Key>
+      struct key_limits {
+         static Key lowest() { return std::numeric_limits<Key>::lowest(); }
+      };
+   }
+
+   template<name::raw TableName, typename T, typename... Indices>
+   class multi_index {
+      private:
+         static constexpr size_t num_indices = sizeof...(Indices);
+
+         struct item {
+            T    obj;
+            name payer;
+         };
+
+         typedef std::map<uint64_t, item> rows_type;
+
+         template<typename Index>
+         using key_set = std::set<std::pair<typename Index::secondary_extractor_type::result_type, uint64_t>>;
+
+         struct scope_data {
+            rows_type                        rows;
+            std::tuple<key_set<Indices>...>  keys;
+         };
+
+         typedef std::map<std::pair<uint64_t, uint64_t>, scope_data> store_type;
+
+         static store_type& store() {
+            static store_type* s = [] {
+               auto p = new store_type();
+               host().table_resets.push_back( [p]{ p->clear(); } );
+               host().table_snapshots.push_back( [p]() -> std::function<void()> {
+                  auto copy = std::make_shared<store_type>( *p );
+                  return [p, copy]{ *p = *copy; };
+               } );
+               return p;
+            }();
+            return *s;
+         }
+
+         name        _code;
+         uint64_t    _scope;
+         scope_data* _data;
+
+         template<size_t I>
+         void insert_keys( const T& obj ) {
+            if constexpr( I < num_indices ) {
+               using index_t = std::tuple_element_t<I, std::tuple<Indices...>>;
+               typename index_t::secondary_extractor_type ex;
+               std::get<I>( _data->keys ).insert( { ex( obj ), obj.primary_key() } );
+               insert_keys<I + 1>( obj );
+            }
+         }
+
+         template<size_t I>
+         void erase_keys( const T& obj ) {
+            if constexpr( I < num_indices ) {
+               using index_t = std::tuple_element_t<I, std::tuple<Indices...>>;
+               typename index_t::secondary_extractor_type ex;
+               std::get<I>( _data->keys ).erase( { ex( obj ), obj.primary_key() } );
+               erase_keys<I + 1>( obj );
+            }
+         }
+
+         template<uint64_t IndexName, size_t I = 0>
+         static constexpr size_t index_position() {
+            static_assert( I < num_indices, "name provided is not the name of any secondary index within multi_index" );
+            if constexpr( std::tuple_element_t<I, std::tuple<Indices...>>::index_name == IndexName )
+               return I;
+            else
+               return index_position<IndexName, I + 1>();
+         }
+
+      public:
+         class const_iterator {
+            public:
+               typedef std::bidirectional_iterator_tag iterator_category;
+               typedef const T value_type;
+               typedef std::ptrdiff_t difference_type;
+               typedef const T* pointer;
+               typedef const T& reference;
+
+               const_iterator() = default;
+               const T& operator*() const { return _it->second.obj; }
+               const T* operator->() const { return &_it->second.obj; }
+               const_iterator& operator++() { ++_it; return *this; }
+               const_iterator& operator--() { --_it; return *this; }
+               const_iterator operator++(int) { auto t = *this; ++_it; return t; }
+               const_iterator operator--(int) { auto t = *this; --_it; return t; }
+               friend bool operator==( const const_iterator& a, const const_iterator& b ) { return a._it == b._it; }
+               friend bool operator!=( const const_iterator& a, const const_iterator& b ) { return a._it != b._it; }
+
+            private:
+               friend class multi_index;
+               explicit const_iterator( typename rows_type::const_iterator it ) : _it(it) {}
+               typename rows_type::const_iterator _it;
+         };
+
+         template<size_t I>
+         class index {
+            private:
+               typedef std::tuple_element_t<I, std::tuple<Indices...>> index_t;
+               typedef typename index_t::secondary_extractor_type::result_type key_type;
+               typedef key_set<index_t> set_type;
+
+               multi_index* _mi;
+               set_type& keys() const { return std::get<I>( _mi->_data->keys ); }
+
+            public:
+               class const_iterator {
+                  public:
+                     typedef std::bidirectional_iterator_tag iterator_category;
+                     typedef const T value_type;
+                     typedef std::ptrdiff_t difference_type;
+                     typedef const T* pointer;
+                     typedef const T& reference;
+
+                     const_iterator() = default;
+                     const T& operator*() const { return _mi->_data->rows.at( _it->second ).obj; }
+                     const T* operator->() const { return &**this; }
+                     const_iterator& operator++() { ++_it; return *this; }
+                     const_iterator& operator--() { --_it; return *this; }
+                     const_iterator operator++(int) { auto t = *this; ++_it; return t; }
+                     const_iterator operator--(int) { auto t = *this; --_it; return t; }
+                     friend bool operator==( const const_iterator& a, const const_iterator& b ) { return a._it == b._it; }
+                     friend bool operator!=( const const_iterator& a, const const_iterator& b ) { return a._it != b._it; }
+
+                  private:
+                     friend class index;
+                     const_iterator( multi_index* mi, typename set_type::const_iterator it ) : _mi(mi), _it(it) {}
+                     multi_index* _mi = nullptr;
+                     typename set_type::const_iterator _it;
+               };
+
+               explicit index( multi_index* mi ) : _mi(mi) {}
+
+               const_iterator begin() const { return { _mi, keys().begin() }; }
+               const_iterator end() const { return { _mi, keys().end() }; }
+               const_iterator cbegin() const { return begin(); }
+               const_iterator cend() const { return end(); }
+
+               const_iterator lower_bound( const key_type& k ) const {
+                  return { _mi, keys().lower_bound( { k, 0 } ) };
+               }
+               const_iterator upper_bound( const key_type& k ) const {
+                  return { _mi, keys().upper_bound( { k, std::numeric_limits<uint64_t>::max() } ) };
+               }
+               const_iterator find( const key_type& k ) const {
+                  auto it = lower_bound( k );
+                  if( it != end() && it._it->first == k ) return it;
+                  return end();
+               }
+               const T& get( const key_type& k, const char* error_msg = "unable to find secondary key" ) const {
+                  auto it = find( k );
+                  eosio_assert( it != end(), error_msg );
+                  return *it;
+               }
+               const_iterator iterator_to( const T& obj ) const {
+                  typename index_t::secondary_extractor_type ex;
+                  return { _mi, keys().find( { ex( obj ), obj.primary_key() } ) };
+               }
+
+               template<typename Lambda>
+               void modify( const_iterator itr, name payer, Lambda&& updater ) {
+                  _mi->modify( *itr, payer, std::forward<Lambda>(updater) );
+               }
+
+               const_iterator erase( const_iterator itr ) {
+                  eosio_assert( itr != end(), "cannot pass end iterator to erase" );
+                  auto next = itr;
+                  ++next;
+                  auto pk = itr._it->second;
+                  _mi->erase( _mi->get( pk ) );
+                  return next;
+               }
+
+               name get_code() const { return _mi->get_code(); }
+               uint64_t get_scope() const { return _mi->get_scope(); }
+         };
+
+         multi_index( name code, uint64_t scope )
+            : _code(code), _scope(scope), _data( &store()[ { code.value, scope } ] ) {}
+
+         name get_code() const { return _code; }
+         uint64_t get_scope() const { return _scope; }
+
+         const_iterator begin() const { return const_iterator( _data->rows.cbegin() ); }
+         const_iterator end() const { return const_iterator( _data->rows.cend() ); }
+         const_iterator cbegin() const { return begin(); }
+         const_iterator cend() const { return end(); }
+
+         const_iterator lower_bound( uint64_t pk ) const { return const_iterator( _data->rows.lower_bound( pk ) ); }
+         const_iterator upper_bound( uint64_t pk ) const { return const_iterator( _data->rows.upper_bound( pk ) ); }
+         const_iterator find( uint64_t pk ) const { return const_iterator( _data->rows.find( pk ) ); }
+
+         const T& get( uint64_t pk, const char* error_msg = "unable to find key" ) const {
+            auto it = _data->rows.find( pk );
+            eosio_assert( it != _data->rows.end(), error_msg );
+            return it->second.obj;
+         }
+
+         const_iterator iterator_to( const T& obj ) const { return find( obj.primary_key() ); }
+
+         uint64_t available_primary_key() const {
+            if( _data->rows.empty() ) return 0;
+            auto next = _data->rows.rbegin()->first + 1;
+            eosio_assert( next != 0, "next primary key in table is at autoincrement limit" );
+            return next;
+         }
+
+         template<name::raw IndexName>
+         auto get_index() {
+            return index<index_position<static_cast<uint64_t>(IndexName)>()>( this );
+         }
+
+         template<name::raw IndexName>
+         auto get_index() const {
+            return index<index_position<static_cast<uint64_t>(IndexName)>()>( const_cast<multi_index*>( this ) );
+         }
+
+         template<typename Lambda>
+         const_iterator emplace( name payer, Lambda&& constructor ) {
+            eosio_assert( payer.value != 0, "must specify a valid account to pay for new record" );
+            detail::check_ram_payer( _code, payer );
+            T obj{};
+            constructor( obj );
+            auto pk = obj.primary_key();
+            eosio_assert( _data->rows.count( pk ) == 0, "could not insert object, most likely a uniqueness constraint was violated" );
+            auto res = _data->rows.emplace( pk, item{ std::move( obj ), payer } );
+            insert_keys<0>( res.first->second.obj );
+            return const_iterator( res.first );
+         }
+
+         template<typename Lambda>
+         void modify( const_iterator itr, name payer, Lambda&& updater ) {
+            eosio_assert( itr != end(), "cannot pass end iterator to modify" );
+            modify( *itr, payer, std::forward<Lambda>(updater) );
+         }
+
+         template<typename Lambda>
+         void modify( const T& obj, name payer, Lambda&& updater ) {
+            detail::check_ram_payer( _code, payer );
+            auto pk = obj.primary_key();
+            auto it = _data->rows.find( pk );
+            eosio_assert( it != _data->rows.end() && &it->second.obj == &obj, "object passed to modify is not in multi_index" );
+            erase_keys<0>( it->second.obj );
+            updater( it->second.obj );
+            eosio_assert( pk == it->second.obj.primary_key(), "updater cannot change primary key when modifying an object" );
+            if( payer.value != 0 ) it->second.payer = payer;
+            insert_keys<0>( it->second.obj );
+         }
+
+         const_iterator erase( const_iterator itr ) {
+            eosio_assert( itr != end(), "cannot pass end iterator to erase" );
+            const auto& obj = *itr;
+            ++itr;
+            erase( obj );
+            return itr;
+         }
+
+         void erase( const T& obj ) {
+            auto it = _data->rows.find( obj.primary_key() );
+            eosio_assert( it != _data->rows.end() && &it->second.obj == &obj, "object passed to erase is not in multi_index" );
+            erase_keys<0>( it->second.obj );
+            _data->rows.erase( it );
+         }
+
+         /// Stand-in only: RAM payer recorded for a row.
+         name payer_of( const T& obj ) const { return _data->rows.at( obj.primary_key() ).payer; }
+
+         /// Stand-in only: number of rows in this scope.
+         size_t size() const { return _data->rows.size(); }
+   };
+
+} // namespace eosio
@@ -0,0 +1,156 @@
+/**
+ *  Microbenchmarks of the nft contract built natively against the
+ *  in-memory eosiolib stand-in.  Meant to be run under perf or callgrind:
+ *
+ *     perf record -g ./nft_bench --filter=transfer
+ *     valgrind --tool=callgrind ./nft_bench --filter=burn --iterations=10000
+ */
+#include "bench.hpp"
+#include "eosio.nft.hpp"
+
+using namespace eosio;
+
+namespace {
+
+   const name self = "eosio.nft"_n;
+   const name alice = "alice"_n;
+   const name bob = "bob"_n;
+
+   nft nft_contract() {
+      return nft( self, self, datastream<const char*>() );
+   }
+
+   asset nfts( int64_t amount ) {
+      return asset( amount, symbol( "NFT", 0 ) );
+   }
+
+   // Fresh chain state with the "NFT" symbol created and a base uri set
+   void setup() {
+      auto& h = host();
+      h.reset();
+      for( auto acc : { self, alice, bob } )
+         h.create_account( acc );
+
+      h.apply( { self }, []{ nft_contract().create( alice, "NFT" ); } );
+      h.apply( { alice }, []{ nft_contract().setbaseuri( symbol_code( "NFT" ), "https://cdn.example/nft/" ); } );
+   }
+
+   // No uris in builds without per-token uris, the tokens take the base uri
+   vector<string> uris( int64_t count ) {
+      vector<string> result;
+      if( !nft::token_uris )
+         return result;
+      for( int64_t i = 0; i < count; i++ )
+         result.push_back( "token" + std::to_string( i ) + ".json" );
+      return result;
+   }
+
+   // Issues "count" tokens with uris to alice, 1000 per action
+   void populate( int64_t count ) {
+      for( int64_t issued = 0; issued < count; issued += 1000 ) {
+         auto n = std::min<int64_t>( 1000, count - issued );
+         auto batch = uris( n );
+         host().apply( { alice }, [&]{ nft_contract().issue( alice, nfts( n ), batch, "bench", "" ); } );
+      }
+   }
+
+}
+
+static void BM_issue_uris( nftbench::state& st ) {
+   setup();
+   auto batch = uris( st.range(0) );
+   for( auto _ : st ) {
+      host().apply( { alice }, [&]{ nft_contract().issue( alice, nfts( st.range(0) ), batch, "bench", "" ); } );
+   }
+   st.set_items_processed( st.iterations() * st.range(0) );
+}
+BENCHMARK( BM_issue_uris )->Arg( 1 )->Arg( 10 )->Arg( 100 );
+
+static void BM_issue_range( nftbench::state& st ) {
+   setup();
+   for( auto _ : st ) {
+      host().apply( { alice }, [&]{ nft_contract().issue( alice, nfts( st.range(0) ), {}, "bench", "" ); } );
+   }
+   st.set_items_processed( st.iterations() * st.range(0) );
+}
+BENCHMARK( BM_issue_range )->Arg( 1 )->Arg( 1000 );
+
+// Symbol transfers back and forth, alice keeps "range(0)" other tokens
+static void BM_transfer( nftbench::state& st ) {
+   setup();
+   populate( st.range(0) );
+   bool forth = true;
+   for( auto _ : st ) {
+      auto from = forth ? alice : bob;
+      auto to = forth ? bob : alice;
+      host().apply( { from }, [&]{ nft_contract().transfer( from, to, nfts( 1 ), "" ); } );
+      forth = !forth;
+   }
+}
+BENCHMARK( BM_transfer )->Arg( 1000 )->Arg( 100000 );
+
+static void BM_transferid( nftbench::state& st ) {
+   setup();
+   populate( st.range(0) );
+   id_type id = st.range(0) / 2;
+   bool forth = true;
+   for( auto _ : st ) {
+      auto from = forth ? alice : bob;
+      auto to = forth ? bob : alice;
+      host().apply( { from }, [&]{ nft_contract().transferid( from, to, id, "" ); } );
+      forth = !forth;
+   }
+}
+BENCHMARK( BM_transferid )->Arg( 1000 )->Arg( 100000 );
+
+// Batches of "range(0)" ids sent back and forth
+static void BM_transferids( nftbench::state& st ) {
+   setup();
+   populate( 10000 );
+   vector<id_type> ids;
+   for( int64_t i = 0; i < st.range(0); i++ )
+      ids.push_back( i * 7 );
+
+   bool forth = true;
+   for( auto _ : st ) {
+      auto from = forth ? alice : bob;
+      auto to = forth ? bob : alice;
+      host().apply( { from }, [&]{ nft_contract().transferids( from, to, ids, "" ); } );
+      forth = !forth;
+   }
+   st.set_items_processed( st.iterations() * ids.size() );
+}
+BENCHMARK( BM_transferids )->Arg( 10 )->Arg( 100 );
+
+// Burns tokens that have a row of their own, minting is not timed
+static void BM_burn( nftbench::state& st ) {
+   setup();
+   populate( st.range(0) );
+   auto batch = uris( 1 );
+   id_type id = st.range(0);
+   for( auto _ : st ) {
+      st.pause_timing();
+      host().apply( { alice }, [&]{ nft_contract().issue( alice, nfts( 1 ), batch, "bench", "" ); } );
+      st.resume_timing();
+
+      host().apply( { alice }, [&]{ nft_contract().burn( alice, id ); } );
+      ++id;
+   }
+}
+BENCHMARK( BM_burn )->Arg( 1000 )->Arg( 100000 );
+
+// Burns tokens from the front of one lazily issued range
+static void BM_burn_range( nftbench::state& st ) {
+   setup();
+   host().apply( { alice }, [&]{ nft_contract().issue( alice, nfts( nfts(0).max_amount ), {}, "bench", "" ); } );
+   id_type id = 0;
+   for( auto _ : st ) {
+      host().apply( { alice }, [&]{ nft_contract().burn( alice, id ); } );
+      ++id;
+   }
+}
+BENCHMARK( BM_burn_range );
+
+int main( int argc, char** argv ) {
+   return nftbench::run_all( argc, argv );
+}
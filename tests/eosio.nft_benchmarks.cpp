@@ -0,0 +1,284 @@
+#include <boost/test/unit_test.hpp>
+#include <eosio/testing/tester.hpp>
+#include <eosio/chain/abi_serializer.hpp>
+#include <eosio/chain/resource_limits.hpp>
+#include <eosio/chain/contract_table_objects.hpp>
+
+#include "eosio.nft_tester.hpp"
+
+#include <fc/io/json.hpp>
+#include <fc/variant_object.hpp>
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+using namespace eosio::testing;
+using namespace eosio;
+using namespace eosio::chain;
+using namespace fc;
+using namespace std;
+
+using mvo = fc::mutable_variant_object;
+
+// Scaling benchmarks for every eosio.nft action.
+//
+// Each action is pushed against a table pre-populated with 1k, 10k and 100k
+// tokens and the billed CPU, NET and RAM of its transaction are recorded.
+// The suite is disabled by default, run it with
+//
+//    ./unit_test -t eosio_nft_benchmarks
+//
+// Environment variables:
+//    NFT_BENCH_SIZES      comma separated table sizes (default 1000,10000,100000)
+//    NFT_BENCH_REPS       runs per action, CPU is the median (default 5)
+//    NFT_BENCH_OUTPUT     path prefix of the .json and .csv results (default nft_benchmarks)
+//    NFT_BENCH_BASELINE   results .json of a previous run to compare against
+//    NFT_BENCH_THRESHOLD  allowed CPU and RAM increase over the baseline in percent (default 25)
+//    NFT_BENCH_DUMP       path prefix of a row dump of the contract tables per size, the
+//                         input of tools/snapshot
+
+namespace {
+
+   string env_or( const char* var, const string& def ) {
+      const char* value = getenv( var );
+      return value && *value ? string( value ) : def;
+   }
+
+   vector<uint32_t> bench_sizes() {
+      vector<uint32_t> sizes;
+      std::stringstream ss( env_or( "NFT_BENCH_SIZES", "1000,10000,100000" ) );
+      string item;
+      while( getline( ss, item, ',' ) )
+         sizes.push_back( std::stoul( item ) );
+      return sizes;
+   }
+
+   struct bench_result {
+      string   action;
+      string   variant;
+      uint32_t tokens;
+      uint32_t cpu_us;
+      uint64_t net_bytes;
+      int64_t  ram_bytes;
+
+      string key() const { return action + "/" + variant + "/" + to_string( tokens ); }
+   };
+
+class nft_bench_tester : public eosio_nft::nft_base_tester {
+public:
+
+   int64_t total_ram() {
+      auto& rlm = control->get_resource_limits_manager();
+      int64_t total = 0;
+      for( auto acc : { N(alice), N(bob), N(carol), N(eosio.nft) } )
+         total += rlm.get_account_ram_usage( acc );
+      return total;
+   }
+
+   vector<string> uris( uint32_t count, const string& prefix ) {
+      vector<string> result;
+      for( uint32_t i = 0; i < count; i++ )
+         result.push_back( prefix + to_string(i) );
+      return result;
+   }
+
+   // Creates "NFT" and issues "count" tokens with uris to alice
+   void populate( uint32_t count ) {
+      push_action_trace( N(eosio.nft), N(create), mvo()
+           ( "issuer", "alice")
+           ( "symbol", "NFT")
+      );
+      produce_blocks(1);
+
+      const uint32_t chunk = 250;
+      for( uint32_t issued = 0; issued < count; issued += chunk ) {
+         auto n = std::min( chunk, count - issued );
+         push_action_trace( N(alice), N(issue), mvo()
+              ( "to", "alice")
+              ( "quantity", asset::from_string( to_string(n) + " NFT" ))
+              ( "uris", uris( n, "pop" + to_string(issued) + "-" ))
+              ( "name", "bench")
+              ( "memo", "populate")
+         );
+         produce_blocks(1);
+      }
+      next_id = count;
+   }
+
+   // Runs "make_action" reps times and keeps the median billed CPU
+   template<typename F>
+   void measure( const string& action, const string& variant, uint32_t tokens, uint32_t reps, F&& make_action ) {
+      vector<uint32_t> cpu;
+      bench_result result{ action, variant, tokens, 0, 0, 0 };
+      for( uint32_t i = 0; i < reps; i++ ) {
+         produce_blocks(1);
+         auto ram_before = total_ram();
+         auto trace = make_action( i );
+         BOOST_REQUIRE( trace->receipt );
+         cpu.push_back( trace->receipt->cpu_usage_us );
+         result.net_bytes = trace->net_usage;
+         result.ram_bytes = total_ram() - ram_before;
+      }
+      std::sort( cpu.begin(), cpu.end() );
+      result.cpu_us = cpu[ cpu.size() / 2 ];
+
+      BOOST_TEST_MESSAGE( result.key() << ": " << result.cpu_us << " us cpu, "
+                          << result.net_bytes << " net bytes, " << result.ram_bytes << " ram bytes" );
+      results.push_back( result );
+   }
+
+   // Every action against a table of "size" tokens
+   void run( uint32_t size, uint32_t reps ) {
+      populate( size );
+
+      measure( "create", "", size, reps, [&]( uint32_t i ) {
+         return push_action_trace( N(eosio.nft), N(create), mvo()
+              ( "issuer", "alice")
+              ( "symbol", string("BEN") + char('A' + i % 26) + char('A' + i / 26) )
+         );
+      });
+
+      for( uint32_t count : { 1, 10, 100, 1000 } ) {
+         measure( "issue", to_string(count) + " uris", size, reps, [&]( uint32_t i ) {
+            auto trace = push_action_trace( N(alice), N(issue), mvo()
+                 ( "to", "bob")
+                 ( "quantity", asset::from_string( to_string(count) + " NFT" ))
+                 ( "uris", uris( count, "bench" + to_string(next_id) + "-" ))
+                 ( "name", "bench")
+                 ( "memo", "measure")
+            );
+            next_id += count;
+            return trace;
+         });
+      }
+
+      // alice still owns every populated token
+      measure( "transfer", "", size, reps, [&]( uint32_t ) {
+         return push_action_trace( N(alice), N(transfer), mvo()
+              ( "from", "alice")
+              ( "to", "carol")
+              ( "quantity", "1 NFT")
+              ( "memo", "measure")
+         );
+      });
+
+      measure( "transferid", "", size, reps, [&]( uint32_t i ) {
+         return push_action_trace( N(alice), N(transferid), mvo()
+              ( "from", "alice")
+              ( "to", "carol")
+              ( "id", size / 2 + i)
+              ( "memo", "measure")
+         );
+      });
+
+      // carol received the tokens above, alice paid for their rows
+      measure( "setrampayer", "", size, reps, [&]( uint32_t i ) {
+         return push_action_trace( N(carol), N(setrampayer), mvo()
+              ( "payer", "carol")
+              ( "id", size / 2 + i)
+         );
+      });
+
+      measure( "burn", "", size, reps, [&]( uint32_t i ) {
+         return push_action_trace( N(carol), N(burn), mvo()
+              ( "owner", "carol")
+              ( "token_id", size / 2 + i)
+         );
+      });
+   }
+
+   // Every eosio.nft table row in the row dump format of tools/snapshot
+   void dump_rows( const string& path ) {
+      std::ofstream out( path, std::ios::binary | std::ios::trunc );
+      out.write( "NFTROWS1", 8 );
+
+      const auto& db = control->db();
+      const auto& tables = db.get_index<table_id_multi_index, by_code_scope_table>();
+      const auto& rows = db.get_index<key_value_index, by_scope_primary>();
+      for( auto t = tables.lower_bound( boost::make_tuple( N(eosio.nft) ) ); t != tables.end() && t->code == N(eosio.nft); ++t ) {
+         for( auto r = rows.lower_bound( boost::make_tuple( t->id ) ); r != rows.end() && r->t_id == t->id; ++r ) {
+            uint64_t keys[3] = { t->scope.value, t->table.value, r->primary_key };
+            uint32_t size = r->value.size();
+            out.write( (const char*)keys, sizeof(keys) );
+            out.write( (const char*)&size, sizeof(size) );
+            out.write( r->value.data(), size );
+         }
+      }
+      BOOST_REQUIRE( out.good() );
+   }
+
+   uint64_t next_id = 0;
+   vector<bench_result> results;
+};
+
+   void write_results( const vector<bench_result>& results, const string& prefix ) {
+      fc::variants rows;
+      std::ofstream csv( prefix + ".csv" );
+      csv << "action,variant,tokens,cpu_us,net_bytes,ram_bytes\n";
+      for( const auto& r : results ) {
+         rows.push_back( mvo()
+            ("action", r.action)
+            ("variant", r.variant)
+            ("tokens", r.tokens)
+            ("cpu_us", r.cpu_us)
+            ("net_bytes", r.net_bytes)
+            ("ram_bytes", r.ram_bytes)
+         );
+         csv << r.action << "," << r.variant << "," << r.tokens << "," << r.cpu_us << ","
+             << r.net_bytes << "," << r.ram_bytes << "\n";
+      }
+      fc::json::save_to_file( fc::variant( rows ), prefix + ".json", true );
+   }
+
+   // Fails for every action whose CPU or RAM grew more than "threshold" percent
+   void check_baseline( const vector<bench_result>& results, const string& baseline_file, double threshold ) {
+      map<string, fc::variant> baseline;
+      for( const auto& row : fc::json::from_file( baseline_file ).get_array() ) {
+         bench_result b{ row["action"].as_string(), row["variant"].as_string(), row["tokens"].as<uint32_t>(), 0, 0, 0 };
+         baseline[ b.key() ] = row;
+      }
+
+      auto limit = [&]( int64_t base ) { return base + std::max<int64_t>( 0, base ) * threshold / 100; };
+      for( const auto& r : results ) {
+         auto it = baseline.find( r.key() );
+         if( it == baseline.end() ) continue;
+
+         auto base_cpu = it->second["cpu_us"].as_int64();
+         auto base_ram = it->second["ram_bytes"].as_int64();
+         BOOST_CHECK_MESSAGE( r.cpu_us <= limit( base_cpu ),
+            r.key() << ": cpu " << r.cpu_us << " us, baseline " << base_cpu << " us" );
+         BOOST_CHECK_MESSAGE( r.ram_bytes <= limit( base_ram ),
+            r.key() << ": ram " << r.ram_bytes << " bytes, baseline " << base_ram << " bytes" );
+      }
+   }
+
+}
+
+BOOST_AUTO_TEST_SUITE(eosio_nft_benchmarks)
+
+BOOST_AUTO_TEST_CASE( action_scaling, * boost::unit_test::disabled() ) try {
+
+   auto reps = std::stoul( env_or( "NFT_BENCH_REPS", "5" ) );
+   BOOST_REQUIRE( reps > 0 );
+
+   vector<bench_result> results;
+   for( auto size : bench_sizes() ) {
+      nft_bench_tester t;
+      t.run( size, reps );
+
+      auto dump = env_or( "NFT_BENCH_DUMP", "" );
+      if( !dump.empty() )
+         t.dump_rows( dump + "-" + to_string( size ) + ".rows" );
+      results.insert( results.end(), t.results.begin(), t.results.end() );
+   }
+
+   write_results( results, env_or( "NFT_BENCH_OUTPUT", "nft_benchmarks" ) );
+
+   auto baseline = env_or( "NFT_BENCH_BASELINE", "" );
+   if( !baseline.empty() )
+      check_baseline( results, baseline, std::stod( env_or( "NFT_BENCH_THRESHOLD", "25" ) ) );
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,282 @@
+#include <boost/test/unit_test.hpp>
+#include <eosio/testing/tester.hpp>
+#include <eosio/chain/abi_serializer.hpp>
+#include <eosio/chain/resource_limits.hpp>
+#include <eosio/chain/contract_table_objects.hpp>
+
+#include "eosio.nft_tester.hpp"
+
+#include <fc/io/json.hpp>
+#include <fc/variant_object.hpp>
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+using namespace eosio::testing;
+using namespace eosio;
+using namespace eosio::chain;
+using namespace fc;
+using namespace std;
+
+using mvo = fc::mutable_variant_object;
+
+// RAM report of eosio.nft after a scripted action sequence.
+//
+// Every row, secondary index entry and table of the contract is attributed to
+// its table, index and RAM payer with the same billable sizes nodeos charges,
+// and the totals are checked against the accounts' RAM usage. The suite is
+// disabled by default, run it with
+//
+//    ./unit_test -t eosio_nft_ram_report
+//
+// Environment variables:
+//    NFT_RAM_SCRIPT   script to run instead of the built-in drop, one action per line:
+//                     <signer[,signer...]> <action> <json data>
+//                     empty lines and lines starting with # are skipped
+
+namespace {
+
+   string env_or( const char* var, const string& def ) {
+      const char* value = getenv( var );
+      return value && *value ? string( value ) : def;
+   }
+
+   struct script_step {
+      vector<account_name> signers;
+      action_name          name;
+      fc::variant          data;
+   };
+
+   vector<script_step> parse_script( std::istream& in ) {
+      vector<script_step> steps;
+      string line;
+      while( getline( in, line ) ) {
+         auto first = line.find_first_not_of( " \t" );
+         if( first == string::npos || line[first] == '#' ) continue;
+
+         std::istringstream ss( line );
+         string signers, action, json;
+         ss >> signers >> action;
+         getline( ss, json );
+         BOOST_REQUIRE_MESSAGE( !action.empty() && !json.empty(), "bad script line: " << line );
+
+         script_step step{ {}, action_name( action ), fc::json::from_string( json ) };
+         std::istringstream names( signers );
+         string signer;
+         while( getline( names, signer, ',' ) )
+            step.signers.push_back( account_name( signer ) );
+         steps.push_back( step );
+      }
+      return steps;
+   }
+
+   // A drop: uri, range and hash issuance, then trading among the accounts
+   const char* default_script = R"(
+eosio.nft create {"issuer":"alice","symbol":"NFT"}
+alice setbaseuri {"sym":"NFT","base_uri":"https://cdn.example/nft/"}
+alice issue {"to":"alice","quantity":"25 NFT","uris":["a0","a1","a2","a3","a4","a5","a6","a7","a8","a9","b0","b1","b2","b3","b4","b5","b6","b7","b8","b9","c0","c1","c2","c3","c4"],"name":"drop","memo":""}
+alice issue {"to":"alice","quantity":"1000 NFT","uris":[],"name":"drop","memo":""}
+alice issuehash {"to":"alice","quantity":"2 NFT","hashes":["0101010101010101010101010101010101010101010101010101010101010101","0202020202020202020202020202020202020202020202020202020202020202"],"name":"drop","memo":""}
+alice transferid {"from":"alice","to":"bob","id":0,"memo":""}
+alice transferids {"from":"alice","to":"bob","ids":[1,2,30,31,1025],"memo":""}
+alice transfer {"from":"alice","to":"carol","quantity":"1 NFT","memo":""}
+bob setrampayer {"payer":"bob","id":0}
+alice approveall {"owner":"alice","spender":"market","approved":true}
+market transferid {"from":"alice","to":"carol","id":40,"memo":""}
+bob,carol swap {"legs":[{"from":"bob","to":"carol","id":1},{"from":"carol","to":"bob","id":40}],"memo":""}
+)";
+
+   struct usage {
+      uint64_t entries = 0;
+      int64_t  bytes = 0;
+      map<account_name, int64_t> by_payer;
+
+      void add( account_name payer, int64_t size ) {
+         entries++;
+         bytes += size;
+         by_payer[payer] += size;
+      }
+   };
+
+class nft_ram_tester : public eosio_nft::nft_base_tester {
+public:
+
+   nft_ram_tester() {
+      for( auto acc : accounts )
+         ram_before[acc] = control->get_resource_limits_manager().get_account_ram_usage( acc );
+   }
+
+   void run( const script_step& step ) {
+      action act;
+      act.account = N(eosio.nft);
+      act.name    = step.name;
+      act.data    = abi_ser.variant_to_binary( abi_ser.get_action_type( step.name ), step.data, abi_serializer_max_time );
+      for( auto signer : step.signers )
+         act.authorization.push_back( permission_level{ signer, config::active_name } );
+
+      signed_transaction trx;
+      trx.actions.emplace_back( std::move(act) );
+      set_transaction_headers( trx );
+      for( auto signer : step.signers )
+         trx.sign( get_private_key( signer, "active" ), control->get_chain_id() );
+      push_transaction( trx );
+      produce_blocks(1);
+   }
+
+   // Secondary index names of the contract, by table and index number
+   static string index_name( name table, uint64_t number ) {
+      static const map<pair<string, uint64_t>, string> names = {
+         { { "tokens", 0 }, "byowner" },
+         { { "ranges", 0 }, "byowner" },
+         { { "hashtokens", 0 }, "byowner" },
+         { { "hashtokens", 1 }, "byhash" },
+         { { "stat", 0 }, "byissuer" },
+         { { "token", 0 }, "byowner" },
+         { { "token", 1 }, "bysymbol" },
+      };
+      auto it = names.find( { table.to_string(), number } );
+      return table.to_string() + "." + ( it != names.end() ? it->second : "idx" + to_string( number ) );
+   }
+
+   template<typename Index, typename Object>
+   void add_secondary( const table_id_object& t, const string& key ) {
+      const auto& idx = control->db().get_index<Index, by_primary>();
+      for( auto itr = idx.lower_bound( boost::make_tuple( t.id ) ); itr != idx.end() && itr->t_id == t.id; ++itr )
+         indexes[key].add( itr->payer, config::billable_size_v<Object> );
+   }
+
+   // Attributes every byte the contract's state is billed for
+   void collect() {
+      const auto& db = control->db();
+      const auto& table_ids = db.get_index<table_id_multi_index, by_code_scope_table>();
+      const auto& rows = db.get_index<key_value_index, by_scope_primary>();
+
+      for( auto t = table_ids.lower_bound( boost::make_tuple( N(eosio.nft) ) ); t != table_ids.end() && t->code == N(eosio.nft); ++t ) {
+         // The first secondary index shares the table id of its primary table,
+         // others are stored under the table name with the index number in the low bits
+         name base( t->table.value & 0xFFFFFFFFFFFFFFF0ULL );
+         uint64_t number = t->table.value & 0x0F;
+         string table = number == 0 ? t->table.to_string() : base.to_string();
+
+         tables["(table ids)"].add( t->payer, config::billable_size_v<table_id_object> );
+         for( auto r = rows.lower_bound( boost::make_tuple( t->id ) ); r != rows.end() && r->t_id == t->id; ++r ) {
+            tables[table].add( r->payer, r->value.size() + config::billable_size_v<key_value_object> );
+            if( table == "tokens" || table == "hashtokens" ) token_rows++;
+         }
+
+         auto key = index_name( base, number );
+         add_secondary<index64_index, index64_object>( *t, key );
+         add_secondary<index128_index, index128_object>( *t, key );
+         add_secondary<index256_index, index256_object>( *t, key );
+         add_secondary<index_double_index, index_double_object>( *t, key );
+         add_secondary<index_long_double_index, index_long_double_object>( *t, key );
+      }
+      for( auto it = indexes.begin(); it != indexes.end(); )
+         it = it->second.entries ? std::next( it ) : indexes.erase( it );
+   }
+
+   int64_t supply() {
+      int64_t total = 0;
+      for( const auto& s : get_rows_of( N(stat) ) )
+         total += asset::from_string( s["supply"].as_string() ).get_amount();
+      return total;
+   }
+
+   vector<fc::variant> get_rows_of( name table ) {
+      vector<fc::variant> result;
+      const auto& db = control->db();
+      const auto& table_ids = db.get_index<table_id_multi_index, by_code_scope_table>();
+      const auto& rows = db.get_index<key_value_index, by_scope_primary>();
+      string type = abi_ser.get_table_type( table );
+      for( auto t = table_ids.lower_bound( boost::make_tuple( N(eosio.nft) ) ); t != table_ids.end() && t->code == N(eosio.nft); ++t ) {
+         if( t->table != table ) continue;
+         for( auto r = rows.lower_bound( boost::make_tuple( t->id ) ); r != rows.end() && r->t_id == t->id; ++r ) {
+            vector<char> data( r->value.data(), r->value.data() + r->value.size() );
+            result.push_back( abi_ser.binary_to_variant( type, data, abi_serializer_max_time ) );
+         }
+      }
+      return result;
+   }
+
+   static void print( std::ostream& out, const string& title, const map<string, usage>& groups, map<account_name, int64_t>& totals ) {
+      out << title << "\n";
+      for( const auto& g : groups ) {
+         out << "  " << std::left << std::setw( 24 ) << g.first << std::right
+             << std::setw( 8 ) << g.second.entries << " entries " << std::setw( 10 ) << g.second.bytes << " bytes  ";
+         for( const auto& p : g.second.by_payer ) {
+            out << " " << p.first.to_string() << "=" << p.second;
+            totals[p.first] += p.second;
+         }
+         out << "\n";
+      }
+   }
+
+   void report( std::ostream& out ) {
+      map<account_name, int64_t> totals;
+      print( out, "tables", tables, totals );
+      print( out, "secondary indexes", indexes, totals );
+
+      int64_t token_bytes = 0;
+      for( const auto& table : { "tokens", "tokenmeta", "ranges", "hashtokens", "inventory", "batches" } ) {
+         auto it = tables.find( table );
+         if( it != tables.end() ) token_bytes += it->second.bytes;
+      }
+      for( const auto& i : indexes ) {
+         if( i.first.rfind( "tokens.", 0 ) == 0 || i.first.rfind( "ranges.", 0 ) == 0 || i.first.rfind( "hashtokens.", 0 ) == 0 )
+            token_bytes += i.second.bytes;
+      }
+
+      auto tokens = supply();
+      out << "per token\n";
+      out << "  " << tokens << " tokens, " << token_rows << " with a row of their own\n";
+      if( tokens > 0 )
+         out << "  " << token_bytes / tokens << " bytes per token in token, metadata, range, inventory and batch rows and their indexes\n";
+
+      // Attributed bytes must add up to what each account was billed
+      out << "payers\n";
+      auto& rlm = control->get_resource_limits_manager();
+      for( auto acc : accounts ) {
+         auto billed = rlm.get_account_ram_usage( acc ) - ram_before[acc];
+         out << "  " << std::left << std::setw( 12 ) << acc.to_string() << std::right << std::setw( 10 ) << totals[acc]
+             << " bytes, account usage grew by " << billed << "\n";
+         BOOST_CHECK_EQUAL( totals[acc], billed );
+      }
+   }
+
+   const vector<account_name> accounts = { N(alice), N(bob), N(carol), N(market), N(eosio.nft) };
+   map<account_name, int64_t> ram_before;
+   map<string, usage> tables;
+   map<string, usage> indexes;
+   uint64_t token_rows = 0;
+};
+
+}
+
+BOOST_AUTO_TEST_SUITE(eosio_nft_ram_report)
+
+BOOST_AUTO_TEST_CASE( ram_report, * boost::unit_test::disabled() ) try {
+
+   vector<script_step> steps;
+   auto script = env_or( "NFT_RAM_SCRIPT", "" );
+   if( script.empty() ) {
+      std::istringstream in( default_script );
+      steps = parse_script( in );
+   } else {
+      std::ifstream in( script );
+      BOOST_REQUIRE_MESSAGE( in, "cannot open " << script );
+      steps = parse_script( in );
+   }
+
+   nft_ram_tester t;
+   for( const auto& step : steps )
+      t.run( step );
+
+   t.collect();
+   t.report( std::cout );
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <boost/test/unit_test.hpp>
+#include <eosio/testing/tester.hpp>
+#include <eosio/chain/abi_serializer.hpp>
+
+#include "contracts.hpp"
+
+#include <fc/variant_object.hpp>
+
+namespace eosio_nft {
+
+using namespace eosio::testing;
+using namespace eosio::chain;
+
+// Fixture shared by the eosio.nft unit tests, benchmarks and RAM report:
+// the test accounts, the contract with its ABI, and action helpers.
+class nft_base_tester : public tester {
+public:
+
+   nft_base_tester() {
+      produce_blocks( 2 );
+
+      create_accounts( { N(alice), N(bob), N(carol), N(market), N(eosio.nft) } );
+      produce_blocks( 2 );
+
+      deploy( contracts::nft_wasm(), contracts::nft_abi() );
+   }
+
+   // Sets the code and ABI of eosio.nft and loads the ABI for the helpers
+   void deploy( const std::vector<uint8_t>& wasm, const std::vector<char>& abi_json ) {
+      set_code( N(eosio.nft), wasm );
+      set_abi( N(eosio.nft), abi_json.data() );
+
+      produce_blocks();
+
+      const auto& accnt = control->db().get<account_object,by_name>( N(eosio.nft) );
+      abi_def abi;
+      BOOST_REQUIRE_EQUAL(abi_serializer::to_abi(accnt.abi, abi), true);
+      abi_ser.set_abi(abi, abi_serializer_max_time);
+   }
+
+   action_result push_action( const account_name& signer, const action_name &name, const fc::variant_object &data ) {
+      std::string action_type_name = abi_ser.get_action_type(name);
+
+      action act;
+      act.account = N(eosio.nft);
+      act.name    = name;
+      act.data    = abi_ser.variant_to_binary( action_type_name, data, abi_serializer_max_time );
+
+      return base_tester::push_action( std::move(act), uint64_t(signer));
+   }
+
+   // Pushes the action in its own transaction and returns the trace.
+   // CPU is billed from the measured time, not the tester's fixed default.
+   transaction_trace_ptr push_action_trace( const account_name& signer, const action_name &name, const fc::variant_object &data ) {
+      std::string action_type_name = abi_ser.get_action_type(name);
+
+      action act;
+      act.account = N(eosio.nft);
+      act.name    = name;
+      act.data    = abi_ser.variant_to_binary( action_type_name, data, abi_serializer_max_time );
+      act.authorization = std::vector<permission_level>{ {signer, config::active_name} };
+
+      signed_transaction trx;
+      trx.actions.emplace_back( std::move(act) );
+      set_transaction_headers( trx );
+      trx.sign( get_private_key( signer, "active" ), control->get_chain_id() );
+
+      return push_transaction( trx, fc::time_point::maximum(), 0 );
+   }
+
+   abi_serializer abi_ser;
+};
+
+} // namespace eosio_nft
@@ -1,8 +1,10 @@
 #include <boost/test/unit_test.hpp>
 #include <eosio/testing/tester.hpp>
 #include <eosio/chain/abi_serializer.hpp>
+#include <eosio/chain/contract_table_objects.hpp>
 
 #include "eosio.system_tester.hpp"
+#include "eosio.nft_tester.hpp"
 
 #include <Runtime/Runtime.h>
 
@@ -14,41 +16,19 @@ using namespace eosio::chain;
 using namespace eosio::testing;
 using namespace fc;
 using namespace std;
+using namespace eosio_nft;
 
 using mvo = fc::mutable_variant_object;
 
 typedef uint64_t id_type;
 typedef string uri_type;
 
-class nft_tester : public tester {
+class nft_tester : public nft_base_tester {
 public:
 
-   nft_tester() {
-      produce_blocks( 2 );
-
-      create_accounts( { N(alice), N(bob), N(carol), N(eosio.nft) } );
-      produce_blocks( 2 );
-
-      set_code( N(eosio.nft), contracts::nft_wasm() );
-      set_abi( N(eosio.nft), contracts::nft_abi().data() );
-
-      produce_blocks();
-
-      const auto& accnt = control->db().get<account_object,by_name>( N(eosio.nft) );
-      abi_def abi;
-      BOOST_REQUIRE_EQUAL(abi_serializer::to_abi(accnt.abi, abi), true);
-      abi_ser.set_abi(abi, abi_serializer_max_time);
-   }
-
-   action_result push_action( const account_name& signer, const action_name &name, const variant_object &data ) {
-      string action_type_name = abi_ser.get_action_type(name);
-
-      action act;
-      act.account = N(eosio.nft);
-      act.name    = name;
-      act.data    = abi_ser.variant_to_binary( action_type_name, data, abi_serializer_max_time );
-
-      return base_tester::push_action( std::move(act), uint64_t(signer));
+   // Replaces the contract with one of its specialized builds
+   void use_variant( const string& variant ) {
+      deploy( contracts::nft_variant_wasm( variant ), contracts::nft_variant_abi( variant ) );
    }
 
    fc::variant get_stats( const string& symbolname )
@@ -67,11 +47,52 @@ public:
       return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "account", data, abi_serializer_max_time );
    }
 
-   fc::variant get_token(id_type token_id) 
+   fc::variant get_token(id_type token_id, const string& symbolname = "0,NFT")
    {
-      vector<char> data = get_row_by_account( N(eosio.nft), N(eosio.nft), N(token), token_id );
+      auto symb = eosio::chain::symbol::from_string(symbolname);
+      auto symbol_code = symb.to_symbol_code().value;
+      vector<char> data = get_row_by_account( N(eosio.nft), symbol_code, N(tokens), token_id );
       FC_ASSERT(!data.empty(), "empty token");
-      return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "token", data, abi_serializer_max_time );
+
+      // Token row with the uri of its metadata row, empty without one
+      mvo token( abi_ser.binary_to_variant( "token", data, abi_serializer_max_time ) );
+      vector<char> meta = get_row_by_account( N(eosio.nft), symbol_code, N(tokenmeta), token_id );
+      token( "uri", meta.empty() ? string() : abi_ser.binary_to_variant( "tokenmeta", meta, abi_serializer_max_time )["uri"].as_string() );
+      return token;
+   }
+
+   fc::variant get_collection( const string& symbolname )
+   {
+      auto symb = eosio::chain::symbol::from_string(symbolname);
+      auto symbol_code = symb.to_symbol_code().value;
+      vector<char> data = get_row_by_account( N(eosio.nft), N(eosio.nft), N(collection), symbol_code );
+      return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "collection", data, abi_serializer_max_time );
+   }
+
+   fc::variant get_range( id_type start, const string& symbolname = "0,NFT" )
+   {
+      auto symb = eosio::chain::symbol::from_string(symbolname);
+      auto symbol_code = symb.to_symbol_code().value;
+      vector<char> data = get_row_by_account( N(eosio.nft), symbol_code, N(ranges), start );
+      return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "range", data, abi_serializer_max_time );
+   }
+
+   fc::variant get_batch( id_type start )
+   {
+      vector<char> data = get_row_by_account( N(eosio.nft), N(eosio.nft), N(batches), start );
+      return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "batch", data, abi_serializer_max_time );
+   }
+
+   fc::variant get_issuejob( uint64_t job_id )
+   {
+      vector<char> data = get_row_by_account( N(eosio.nft), N(eosio.nft), N(issuejobs), job_id );
+      return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "issuejob", data, abi_serializer_max_time );
+   }
+
+   fc::variant get_migration()
+   {
+      vector<char> data = get_row_by_account( N(eosio.nft), N(eosio.nft), N(migration), N(migration) );
+      return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "migration", data, abi_serializer_max_time );
    }
 
    action_result create( account_name issuer,
@@ -117,6 +138,249 @@ public:
       );
    }
 
+   action_result transferids( account_name from,
+                  account_name to,
+                  vector<id_type> ids,
+                  string       memo ) {
+      return push_action( from, N(transferids), mvo()
+           ( "from", from)
+           ( "to", to)
+           ( "ids", ids)
+           ( "memo", memo)
+      );
+   }
+
+   // Swap of "legs", each a from, to and id, signed by every account in "signers"
+   action_result swap( const vector<account_name>& signers, const vector<std::tuple<account_name, account_name, id_type>>& legs, const string& memo ) {
+      fc::variants leg_list;
+      for( const auto& leg : legs )
+         leg_list.push_back( mvo()( "from", std::get<0>(leg) )( "to", std::get<1>(leg) )( "id", std::get<2>(leg) ) );
+
+      return push_signed_action( signers, N(swap), mvo()( "legs", leg_list )( "memo", memo ) );
+   }
+
+   // Deploys to "caller" a contract that sends an inline action of eosio.nft
+   // named "name" with "data", authorized by the caller, whenever one of the
+   // caller's own actions runs
+   void set_inline_caller( account_name caller, const action_name& name, const variant_object& data ) {
+      action act;
+      act.account = N(eosio.nft);
+      act.name    = name;
+      act.data    = abi_ser.variant_to_binary( abi_ser.get_action_type( name ), data, abi_serializer_max_time );
+      act.authorization.push_back( permission_level{ caller, config::active_name } );
+
+      auto packed = fc::raw::pack( act );
+      string bytes;
+      for( unsigned char c : packed ) {
+         char hex[4];
+         snprintf( hex, sizeof(hex), "\\%02x", c );
+         bytes += hex;
+      }
+
+      string wast = R"=====(
+(module
+ (import "env" "send_inline" (func $send_inline (param i32 i32)))
+ (memory $0 1)
+ (export "memory" (memory $0))
+ (export "apply" (func $apply))
+ (data (i32.const 16) ")=====" + bytes + R"=====(")
+ (func $apply (param $receiver i64) (param $code i64) (param $action i64)
+  (if (i64.eq (get_local $receiver) (get_local $code))
+   (call $send_inline (i32.const 16) (i32.const )=====" + to_string( packed.size() ) + R"=====())
+  )
+ )
+)
+)=====";
+      set_code( caller, wast.c_str() );
+
+      // The contract may use the caller's active permission
+      set_authority( caller, config::active_name,
+         authority( 1, { key_weight{ get_public_key( caller, "active" ), 1 } },
+                       { permission_level_weight{ { caller, config::eosio_code_name }, 1 } } ),
+         config::owner_name );
+      produce_blocks();
+   }
+
+   // Action signed by every account in "signers"
+   action_result push_signed_action( const vector<account_name>& signers, const action_name& name, const variant_object& data ) {
+      action act;
+      act.account = N(eosio.nft);
+      act.name    = name;
+      act.data    = abi_ser.variant_to_binary( abi_ser.get_action_type( name ), data, abi_serializer_max_time );
+      for( auto signer : signers )
+         act.authorization.push_back( permission_level{ signer, config::active_name } );
+
+      signed_transaction trx;
+      trx.actions.emplace_back( std::move(act) );
+      set_transaction_headers( trx );
+      for( auto signer : signers )
+         trx.sign( get_private_key( signer, "active" ), control->get_chain_id() );
+
+      try {
+         push_transaction( trx );
+      } catch( const fc::exception& ex ) {
+         return error( ex.top_message() );
+      }
+      produce_block();
+      return success();
+   }
+
+   action_result burnids( account_name owner, vector<id_type> ids ){
+   	return push_action( owner, N(burnids), mvo()
+	   ( "owner", owner)
+	   ( "ids", ids)
+	);
+   }
+
+   // Number of notifications "account" received in the transaction
+   size_t notifications( const transaction_trace_ptr& trace, account_name account ) {
+      size_t count = 0;
+      std::function<void(const action_trace&)> walk = [&]( const action_trace& at ) {
+         if( at.receipt.receiver == account && at.act.account != account ) count++;
+         for( const auto& inl : at.inline_traces ) walk( inl );
+      };
+      for( const auto& at : trace->action_traces ) walk( at );
+      return count;
+   }
+
+   // Issues "count" tokens with generated uris
+   action_result issue_n( account_name issuer, account_name to, const string& symbol, uint32_t count, const string& name = "nft1" ) {
+      vector<string> uris;
+      for( uint32_t i = 0; i < count; i++ )
+      {
+         uris.push_back( "uri" + to_string(i) );
+      }
+      return issue( issuer, to, asset::from_string( to_string(count) + " " + symbol ), uris, name, "batch" );
+   }
+
+   // Lowest billed CPU of a symbol transfer over a few round trips
+   uint32_t transfer_cpu( account_name from, account_name to, const string& quantity ) {
+      uint32_t best = std::numeric_limits<uint32_t>::max();
+      for( auto i = 0; i < 3; i++ )
+      {
+         auto trace = push_action_trace( from, N(transfer), mvo()
+              ( "from", from)
+              ( "to", to)
+              ( "quantity", quantity)
+              ( "memo", "measure")
+         );
+         best = std::min( best, trace->receipt->cpu_usage_us );
+         produce_blocks(1);
+
+         push_action_trace( to, N(transfer), mvo()
+              ( "from", to)
+              ( "to", from)
+              ( "quantity", quantity)
+              ( "memo", "send back")
+         );
+         produce_blocks(1);
+      }
+      return best;
+   }
+
+   // Every row of an eosio.nft table in "scope"
+   vector<fc::variant> get_rows( uint64_t scope, const name& table, const string& type )
+   {
+      vector<fc::variant> rows;
+      const auto& db = control->db();
+      const auto* t_id = db.find<table_id_object, by_code_scope_table>( boost::make_tuple( N(eosio.nft), scope, table ) );
+      if( !t_id ) return rows;
+
+      const auto& idx = db.get_index<key_value_index, by_scope_primary>();
+      for( auto itr = idx.lower_bound( boost::make_tuple( t_id->id, 0 ) ); itr != idx.end() && itr->t_id == t_id->id; ++itr ) {
+         vector<char> data( itr->value.data(), itr->value.data() + itr->value.size() );
+         rows.push_back( abi_ser.binary_to_variant( type, data, abi_serializer_max_time ) );
+      }
+      return rows;
+   }
+
+   // Rows written straight to the database stand in for a deployment of an
+   // earlier version of the contract, none of the actions writes the old layout
+   const table_id_object& stored_table( uint64_t scope, name table )
+   {
+      auto& db = const_cast<chainbase::database&>( control->db() );
+      const auto* t_id = db.find<table_id_object, by_code_scope_table>( boost::make_tuple( N(eosio.nft), scope, table ) );
+      if( t_id ) return *t_id;
+      return db.create<table_id_object>( [&]( auto& t ) {
+         t.code  = N(eosio.nft);
+         t.scope = scope;
+         t.table = table;
+         t.payer = N(eosio.nft);
+      });
+   }
+
+   void store_row( uint64_t scope, name table, uint64_t primary_key, const string& type, const fc::variant& row )
+   {
+      auto& db = const_cast<chainbase::database&>( control->db() );
+      auto data = abi_ser.variant_to_binary( type, row, abi_serializer_max_time );
+      const auto& t_id = stored_table( scope, table );
+
+      const auto* existing = db.find<key_value_object, by_scope_primary>( boost::make_tuple( t_id.id, primary_key ) );
+      if( existing ) {
+         db.modify( *existing, [&]( auto& o ) {
+            o.value.assign( data.data(), data.size() );
+         });
+         return;
+      }
+      db.create<key_value_object>( [&]( auto& o ) {
+         o.t_id        = t_id.id;
+         o.primary_key = primary_key;
+         o.value.assign( data.data(), data.size() );
+         o.payer       = N(eosio.nft);
+      });
+      db.modify( t_id, [&]( auto& t ) { ++t.count; } );
+   }
+
+   // Secondary index tables carry the index number in the low bits of the table name
+   template<typename Object, typename Key>
+   void store_secondary( uint64_t scope, name table, uint64_t number, uint64_t primary_key, const Key& key )
+   {
+      auto& db = const_cast<chainbase::database&>( control->db() );
+      const auto& t_id = stored_table( scope, name( table.value | number ) );
+      db.create<Object>( [&]( auto& o ) {
+         o.t_id          = t_id.id;
+         o.primary_key   = primary_key;
+         o.secondary_key = key;
+         o.payer         = N(eosio.nft);
+      });
+      db.modify( t_id, [&]( auto& t ) { ++t.count; } );
+   }
+
+   // Token row of schema version 0 with its byowner and bysymbol entries
+   void store_legacy_token( id_type id, const string& uri, account_name owner, const string& value, const string& token_name )
+   {
+      uint64_t sym = asset::from_string( value ).get_symbol().to_symbol_code().value;
+      store_row( N(eosio.nft), N(token), id, "legacy_token", mvo()
+         ("id", id)
+         ("uri", uri)
+         ("owner", owner)
+         ("value", value)
+         ("tokenName", token_name)
+      );
+      store_secondary<index64_object>( N(eosio.nft), N(token), 0, id, owner.value );
+      store_secondary<index64_object>( N(eosio.nft), N(token), 1, id, sym );
+   }
+
+   // Owner inventories hold exactly the tokens and ranges of the symbols' tables
+   void check_inventory( const vector<string>& symbols, const vector<account_name>& owners )
+   {
+      map<pair<string, uint64_t>, string> expected, actual;
+      for( const auto& symbolname : symbols ) {
+         auto symbol_code = eosio::chain::symbol::from_string(symbolname).to_symbol_code().value;
+         for( const auto& t : get_rows( symbol_code, N(tokens), "token" ) )
+            expected[{ t["owner"].as_string(), t["id"].as_uint64() }] = "1 " + t["sym"].as_string();
+         for( const auto& r : get_rows( symbol_code, N(ranges), "range" ) )
+            expected[{ r["owner"].as_string(), r["start"].as_uint64() }] = r["count"].as_string() + " " + r["sym"].as_string();
+         for( const auto& t : get_rows( symbol_code, N(hashtokens), "hashtoken" ) )
+            expected[{ t["owner"].as_string(), t["id"].as_uint64() }] = "1 " + t["sym"].as_string();
+      }
+      for( const auto& owner : owners ) {
+         for( const auto& h : get_rows( owner.value, N(inventory), "holding" ) )
+            actual[{ owner.to_string(), h["id"].as_uint64() }] = h["count"].as_string() + " " + h["sym"].as_string();
+      }
+      BOOST_REQUIRE( expected == actual );
+   }
+
    action_result burn( account_name owner, id_type token_id ){
    	return push_action( owner, N(burn), mvo()
 	   ( "owner", owner)
@@ -124,7 +388,6 @@ public:
 	);
    }
 
-   abi_serializer abi_ser;
 };
 
 BOOST_AUTO_TEST_SUITE(eosio_nft_tests)
@@ -179,13 +442,12 @@ BOOST_FIXTURE_TEST_CASE ( issue_multi_tests, nft_tester ) try {
 	for(auto i=0; i<5; i++)
 	{
 		//string indx = to_string(i);
-		auto tokenval = get_token((id_type)i);
+		auto tokenval = get_token((id_type)i, "0,TKN");
 		REQUIRE_MATCHING_OBJECT( tokenval, mvo()
 			("id", i)
 			("uri", uris[i])
 			("owner", "alice")
-			("value", "1 TKN")
-			("tokenName", "nft1")
+			("sym", "TKN")
 		);
 	}
 
@@ -213,13 +475,12 @@ BOOST_FIXTURE_TEST_CASE( issue_tests, nft_tester ) try {
       ("issuer", "alice")
    );
 
-   auto tokenval = get_token(0);
+   auto tokenval = get_token(0, "0,TKN");
    REQUIRE_MATCHING_OBJECT( tokenval, mvo()
       ("id", "0")
       ("uri", "uri")
       ("owner", "bob")
-      ("value", "1 TKN")
-      ("tokenName", "nft1")
+      ("sym", "TKN")
    );
 
 
@@ -283,6 +544,412 @@ BOOST_FIXTURE_TEST_CASE( issue_tests, nft_tester ) try {
 
 } FC_LOG_AND_RETHROW()
 
+BOOST_FIXTURE_TEST_CASE( base_uri_tests, nft_tester ) try {
+
+   create( N(alice), string("NFT"));
+   produce_blocks(1);
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "base uri must be set to issue tokens without uris" ),
+      issue( N(alice), N(alice), asset::from_string("2 NFT"), {}, "nft1", "no uris" )
+   );
+
+   BOOST_REQUIRE_EQUAL( success(),
+      push_action( N(alice), N(setbaseuri), mvo()
+           ( "sym", "NFT")
+           ( "base_uri", "https://cdn.example/collection/123/")
+      )
+   );
+
+   BOOST_REQUIRE_EQUAL( success(),
+      issue( N(alice), N(bob), asset::from_string("2 NFT"), {}, "nft1", "no uris" )
+   );
+   BOOST_REQUIRE_EQUAL( success(),
+      issue( N(alice), N(bob), asset::from_string("1 NFT"), {"special.json"}, "nft1", "suffix" )
+   );
+
+   REQUIRE_MATCHING_OBJECT( get_collection("0,NFT"), mvo()
+      ("sym", "NFT")
+      ("tokenName", "nft1")
+      ("base_uri", "https://cdn.example/collection/123/")
+      ("no_balances", "false")
+   );
+
+   // Only suffixes are stored, empty ones stand for the token id
+   REQUIRE_MATCHING_OBJECT( get_token(1), mvo()
+      ("id", "1")
+      ("uri", "")
+      ("owner", "bob")
+      ("sym", "NFT")
+   );
+   REQUIRE_MATCHING_OBJECT( get_token(2), mvo()
+      ("id", "2")
+      ("uri", "special.json")
+      ("owner", "bob")
+      ("sym", "NFT")
+   );
+
+   REQUIRE_MATCHING_OBJECT( get_stats("0,NFT"), mvo()
+      ("supply", "3 NFT")
+      ("issuer", "alice")
+   );
+
+   BOOST_REQUIRE_EQUAL( error( "missing authority of alice" ),
+      push_action( N(bob), N(setbaseuri), mvo()
+           ( "sym", "NFT")
+           ( "base_uri", "https://bob.example/")
+      )
+   );
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "token with symbol does not exist" ),
+      push_action( N(alice), N(setbaseuri), mvo()
+           ( "sym", "TTT")
+           ( "base_uri", "https://cdn.example/")
+      )
+   );
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( absolute_uri_tests, nft_tester ) try {
+
+   create( N(alice), string("NFT"));
+   produce_blocks(1);
+
+   // Full uris issued while the collection has no base uri
+   BOOST_REQUIRE_EQUAL( success(),
+      issue( N(alice), N(alice), asset::from_string("2 NFT"), {"https://old.example/0.json", "ipfs://QmOld/1.json"}, "nft1", "full uris" )
+   );
+
+   BOOST_REQUIRE_EQUAL( success(),
+      push_action( N(alice), N(setbaseuri), mvo()
+           ( "sym", "NFT")
+           ( "base_uri", "https://cdn.example/nft/")
+      )
+   );
+   BOOST_REQUIRE_EQUAL( success(),
+      issue( N(alice), N(alice), asset::from_string("1 NFT"), {"2.json"}, "nft1", "suffix" )
+   );
+
+   auto nft_code = eosio::chain::symbol(0, "NFT").to_symbol_code().value;
+   auto meta = get_row_by_account( N(eosio.nft), nft_code, N(tokenmeta), 0 );
+   REQUIRE_MATCHING_OBJECT( abi_ser.binary_to_variant( "tokenmeta", meta, abi_serializer_max_time ), mvo()
+      ("id", "0")
+      ("uri", "https://old.example/0.json")
+      ("absolute", "true")
+   );
+   meta = get_row_by_account( N(eosio.nft), nft_code, N(tokenmeta), 2 );
+   REQUIRE_MATCHING_OBJECT( abi_ser.binary_to_variant( "tokenmeta", meta, abi_serializer_max_time ), mvo()
+      ("id", "2")
+      ("uri", "2.json")
+      ("absolute", "false")
+   );
+
+   // The base uri is only prepended to the suffix issued after it
+   auto trace = push_action_trace( N(carol), N(tokensof), mvo()
+        ( "owner", "alice")
+        ( "sym", "NFT")
+        ( "cursor", 0)
+        ( "limit", 3)
+   );
+   BOOST_REQUIRE_EQUAL( "token: 0 NFT https://old.example/0.json\n"
+                        "token: 1 NFT ipfs://QmOld/1.json\n"
+                        "token: 2 NFT https://cdn.example/nft/2.json\n", trace->action_traces[0].console );
+
+   // A later base uri change leaves absolute uris alone as well
+   BOOST_REQUIRE_EQUAL( success(),
+      push_action( N(alice), N(setbaseuri), mvo()
+           ( "sym", "NFT")
+           ( "base_uri", "https://mirror.example/nft/")
+      )
+   );
+   trace = push_action_trace( N(carol), N(tokensof), mvo()
+        ( "owner", "alice")
+        ( "sym", "NFT")
+        ( "cursor", 0)
+        ( "limit", 3)
+   );
+   BOOST_REQUIRE_EQUAL( "token: 0 NFT https://old.example/0.json\n"
+                        "token: 1 NFT ipfs://QmOld/1.json\n"
+                        "token: 2 NFT https://mirror.example/nft/2.json\n", trace->action_traces[0].console );
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( range_issue_tests, nft_tester ) try {
+
+   create( N(alice), string("NFT"));
+   produce_blocks(1);
+
+   push_action( N(alice), N(setbaseuri), mvo()
+        ( "sym", "NFT")
+        ( "base_uri", "https://cdn.example/collection/123/")
+   );
+
+   // Creates bob's balance row
+   issue( N(alice), N(bob), asset::from_string("1 NFT"), {}, "nft1", "first" );
+
+   // Issue cost does not depend on the number of tokens
+   auto& rlm = control->get_resource_limits_manager();
+
+   auto ram_before = rlm.get_account_ram_usage( N(alice) );
+   BOOST_REQUIRE_EQUAL( success(),
+      issue( N(alice), N(bob), asset::from_string("10 NFT"), {}, "nft1", "small drop" )
+   );
+   auto small_bytes = rlm.get_account_ram_usage( N(alice) ) - ram_before;
+
+   ram_before = rlm.get_account_ram_usage( N(alice) );
+   BOOST_REQUIRE_EQUAL( success(),
+      issue( N(alice), N(bob), asset::from_string("10000 NFT"), {}, "nft1", "large drop" )
+   );
+   auto large_bytes = rlm.get_account_ram_usage( N(alice) ) - ram_before;
+
+   BOOST_REQUIRE_EQUAL( small_bytes, large_bytes );
+
+   REQUIRE_MATCHING_OBJECT( get_range(11), mvo()
+      ("start", "11")
+      ("count", "10000")
+      ("owner", "bob")
+      ("sym", "NFT")
+   );
+   REQUIRE_MATCHING_OBJECT( get_stats("0,NFT"), mvo()
+      ("supply", "10011 NFT")
+      ("issuer", "alice")
+   );
+   REQUIRE_MATCHING_OBJECT( get_account(N(bob), "0,NFT"), mvo()
+      ("balance", "10011 NFT")
+   );
+
+   // First transfer gives the token its own row and splits the range
+   BOOST_REQUIRE_EQUAL( success(), transferid( N(bob), N(carol), 500, "from the middle" ) );
+
+   REQUIRE_MATCHING_OBJECT( get_token(500), mvo()
+      ("id", "500")
+      ("uri", "")
+      ("owner", "carol")
+      ("sym", "NFT")
+   );
+   REQUIRE_MATCHING_OBJECT( get_range(11), mvo()
+      ("start", "11")
+      ("count", "489")
+      ("owner", "bob")
+      ("sym", "NFT")
+   );
+   REQUIRE_MATCHING_OBJECT( get_range(501), mvo()
+      ("start", "501")
+      ("count", "9510")
+      ("owner", "bob")
+      ("sym", "NFT")
+   );
+
+   // Burning does not create a row
+   BOOST_REQUIRE_EQUAL( success(), burn( N(bob), 11 ) );
+   BOOST_REQUIRE_EQUAL( true, get_range(11).is_null() );
+   REQUIRE_MATCHING_OBJECT( get_range(12), mvo()
+      ("start", "12")
+      ("count", "488")
+      ("owner", "bob")
+      ("sym", "NFT")
+   );
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "token with id does not exist" ), burn( N(bob), 11 ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "token not owned by account" ), burn( N(carol), 12 ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "sender does not own token with specified ID" ),
+      transferid( N(carol), N(alice), 12, "not carol's" )
+   );
+
+   // Bob has no token rows, symbol transfers take the start of his ranges
+   BOOST_REQUIRE_EQUAL( success(), transfer( N(bob), N(alice), asset::from_string("1 NFT"), "first range" ) );
+   BOOST_REQUIRE_EQUAL( success(), transfer( N(bob), N(alice), asset::from_string("1 NFT"), "second range" ) );
+   REQUIRE_MATCHING_OBJECT( get_token(1), mvo()
+      ("id", "1")
+      ("uri", "")
+      ("owner", "alice")
+      ("sym", "NFT")
+   );
+   BOOST_REQUIRE_EQUAL( true, get_range(0).is_null() );
+   REQUIRE_MATCHING_OBJECT( get_range(2), mvo()
+      ("start", "2")
+      ("count", "9")
+      ("owner", "bob")
+      ("sym", "NFT")
+   );
+
+   REQUIRE_MATCHING_OBJECT( get_account(N(bob), "0,NFT"), mvo()
+      ("balance", "10007 NFT")
+   );
+   REQUIRE_MATCHING_OBJECT( get_stats("0,NFT"), mvo()
+      ("supply", "10010 NFT")
+      ("issuer", "alice")
+   );
+
+   // Ranges of the largest amount can not wrap the global id counter
+   for( string sym : { "AAA", "BBB", "CCC", "DDD" } ) {
+      create( N(alice), sym );
+      push_action( N(alice), N(setbaseuri), mvo()
+           ( "sym", sym)
+           ( "base_uri", "https://cdn.example/" + sym + "/")
+      );
+      auto result = issue( N(alice), N(bob), asset::from_string("4611686018427387903 " + sym), {}, "big", "max amount" );
+      BOOST_REQUIRE_EQUAL( sym == "DDD" ? wasm_assert_msg( "token ids are exhausted" ) : success(), result );
+   }
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( issue_job_tests, nft_tester ) try {
+
+   create( N(alice), string("NFT"));
+   produce_blocks(1);
+
+   BOOST_REQUIRE_EQUAL( success(),
+      push_action( N(alice), N(beginissue), mvo()
+           ( "to", "bob")
+           ( "quantity", "5 NFT")
+           ( "name", "drop")
+           ( "memo", "large drop")
+      )
+   );
+   REQUIRE_MATCHING_OBJECT( get_issuejob(0), mvo()
+      ("id", "0")
+      ("to", "bob")
+      ("quantity", "5 NFT")
+      ("issued", "0")
+      ("tokenName", "")
+   );
+
+   auto continueissue = [&]( account_name signer, uint64_t job_id, vector<string> uris ) {
+      return push_action( signer, N(continueissue), mvo()
+           ( "job_id", job_id)
+           ( "uris", uris)
+      );
+   };
+
+   // Supply and balance grow with every chunk
+   BOOST_REQUIRE_EQUAL( success(), continueissue( N(alice), 0, {"u0", "u1"} ) );
+   REQUIRE_MATCHING_OBJECT( get_stats("0,NFT"), mvo()
+      ("supply", "2 NFT")
+      ("issuer", "alice")
+   );
+   REQUIRE_MATCHING_OBJECT( get_account(N(bob), "0,NFT"), mvo()
+      ("balance", "2 NFT")
+   );
+   REQUIRE_MATCHING_OBJECT( get_issuejob(0), mvo()
+      ("id", "0")
+      ("to", "bob")
+      ("quantity", "5 NFT")
+      ("issued", "2")
+      ("tokenName", "")
+   );
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "more uris than tokens left in issue job" ),
+      continueissue( N(alice), 0, {"u2", "u3", "u4", "u5"} )
+   );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "no uris provided" ),
+      continueissue( N(alice), 0, {} )
+   );
+   BOOST_REQUIRE_EQUAL( error( "missing authority of alice" ),
+      continueissue( N(bob), 0, {"u2"} )
+   );
+
+   // The last chunk closes the job
+   BOOST_REQUIRE_EQUAL( success(), continueissue( N(alice), 0, {"u2", "u3", "u4"} ) );
+   BOOST_REQUIRE_EQUAL( true, get_issuejob(0).is_null() );
+   REQUIRE_MATCHING_OBJECT( get_stats("0,NFT"), mvo()
+      ("supply", "5 NFT")
+      ("issuer", "alice")
+   );
+   REQUIRE_MATCHING_OBJECT( get_token(4), mvo()
+      ("id", "4")
+      ("uri", "u4")
+      ("owner", "bob")
+      ("sym", "NFT")
+   );
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "issue job does not exist" ),
+      continueissue( N(alice), 0, {"u5"} )
+   );
+
+   // A job under another name keeps it for every chunk
+   BOOST_REQUIRE_EQUAL( success(),
+      push_action( N(alice), N(beginissue), mvo()
+           ( "to", "bob")
+           ( "quantity", "2 NFT")
+           ( "name", "other")
+           ( "memo", "")
+      )
+   );
+   REQUIRE_MATCHING_OBJECT( get_issuejob(0), mvo()
+      ("id", "0")
+      ("to", "bob")
+      ("quantity", "2 NFT")
+      ("issued", "0")
+      ("tokenName", "other")
+   );
+   BOOST_REQUIRE_EQUAL( success(), continueissue( N(alice), 0, {"u5"} ) );
+   BOOST_REQUIRE_EQUAL( success(), continueissue( N(alice), 0, {"u6"} ) );
+   REQUIRE_MATCHING_OBJECT( get_batch(5), mvo()
+      ("start", "5")
+      ("count", "2")
+      ("sym", "NFT")
+      ("tokenName", "other")
+   );
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( issuemany_tests, nft_tester ) try {
+
+   create( N(alice), string("NFT"));
+   produce_blocks(1);
+
+   auto issuemany = [&]( account_name signer, vector<pair<string, string>> legs ) {
+      vector<mvo> leg_objects;
+      for( const auto& leg : legs )
+         leg_objects.push_back( mvo()( "to", leg.first )( "uri", leg.second ) );
+      return push_action( signer, N(issuemany), mvo()
+           ( "sym", "NFT")
+           ( "legs", leg_objects)
+           ( "name", "drop")
+           ( "memo", "airdrop")
+      );
+   };
+
+   BOOST_REQUIRE_EQUAL( error( "missing authority of alice" ),
+      issuemany( N(bob), { std::make_pair( "bob", "u0" ) } )
+   );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "to account does not exist" ),
+      issuemany( N(alice), { std::make_pair( "bob", "u0" ), std::make_pair( "nobody", "u1" ) } )
+   );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "base uri must be set to issue tokens without uris" ),
+      issuemany( N(alice), { std::make_pair( "bob", "" ) } )
+   );
+
+   // One balance update per recipient, ids follow the order of the legs
+   BOOST_REQUIRE_EQUAL( success(),
+      issuemany( N(alice), { std::make_pair( "bob", "u0" ), std::make_pair( "carol", "u1" ), std::make_pair( "bob", "u2" ) } )
+   );
+   REQUIRE_MATCHING_OBJECT( get_stats("0,NFT"), mvo()
+      ("supply", "3 NFT")
+      ("issuer", "alice")
+   );
+   REQUIRE_MATCHING_OBJECT( get_account(N(bob), "0,NFT"), mvo()
+      ("balance", "2 NFT")
+   );
+   REQUIRE_MATCHING_OBJECT( get_account(N(carol), "0,NFT"), mvo()
+      ("balance", "1 NFT")
+   );
+   REQUIRE_MATCHING_OBJECT( get_token(1), mvo()
+      ("id", "1")
+      ("uri", "u1")
+      ("owner", "carol")
+      ("sym", "NFT")
+   );
+   REQUIRE_MATCHING_OBJECT( get_batch(0), mvo()
+      ("start", "0")
+      ("count", "3")
+      ("sym", "NFT")
+      ("tokenName", "")
+   );
+   check_inventory( { "0,NFT" }, { N(alice), N(bob), N(carol) } );
+
+} FC_LOG_AND_RETHROW()
+
 BOOST_FIXTURE_TEST_CASE( transfer_tests, nft_tester ) try {
 
    auto token = create( N(alice), string("NFT"));
@@ -345,22 +1012,411 @@ BOOST_FIXTURE_TEST_CASE( transfer_tests, nft_tester ) try {
 
 } FC_LOG_AND_RETHROW()
 
-BOOST_FIXTURE_TEST_CASE( transferid_tests, nft_tester ) try {
+BOOST_FIXTURE_TEST_CASE( transfer_single_action_tests, nft_tester ) try {
 
-   auto token = create( N(alice), string("NFT"));
+   create( N(alice), string("NFT"));
    produce_blocks(1);
 
-   vector<string> uris = {"uri", "uri2", "uri3"};
-
-   issue( N(alice), N(alice), asset::from_string("3 NFT"), uris, "nft1", "hola" );
+   issue_n( N(alice), N(alice), "NFT", 4 );
+   produce_blocks(1);
 
-   transferid( N(alice), N(bob), 0, "send token 0 to bob" );
+   auto trace = push_action_trace( N(alice), N(transfer), mvo()
+        ( "from", "alice")
+        ( "to", "bob")
+        ( "quantity", "1 NFT")
+        ( "memo", "by symbol")
+   );
 
+   // The token moves in the transfer action itself, only notifications follow it
+   BOOST_REQUIRE_EQUAL( 1, trace->action_traces.size() );
+   for( const auto& inl : trace->action_traces[0].inline_traces )
+      BOOST_REQUIRE( inl.receipt.receiver != N(eosio.nft) );
+   BOOST_REQUIRE_EQUAL( 1, notifications( trace, N(alice) ) );
+   BOOST_REQUIRE_EQUAL( 1, notifications( trace, N(bob) ) );
+   auto transfer_cpu = trace->receipt->cpu_usage_us;
+   produce_blocks(1);
 
-   transferid( N(alice), N(bob), 1, "send token 1 to bob" );
+   auto id_trace = push_action_trace( N(alice), N(transferid), mvo()
+        ( "from", "alice")
+        ( "to", "bob")
+        ( "id", 1)
+        ( "memo", "by id")
+   );
+   auto transferid_cpu = id_trace->receipt->cpu_usage_us;
 
+   BOOST_TEST_MESSAGE( "transfer cpu: " << transfer_cpu << " us, transferid cpu: " << transferid_cpu << " us" );
 
-   auto alice_balance = get_account(N(alice), "0,NFT");
+   REQUIRE_MATCHING_OBJECT( get_token(0), mvo()
+      ("id", "0")
+      ("uri", "uri0")
+      ("owner", "bob")
+      ("sym", "NFT")
+   );
+   REQUIRE_MATCHING_OBJECT( get_account(N(bob), "0,NFT"), mvo()
+      ("balance", "2 NFT")
+   );
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( transfer_cpu_flat_tests, nft_tester ) try {
+
+   create( N(alice), string("NFT"));
+   produce_blocks(1);
+
+   issue_n( N(alice), N(bob), "NFT", 10 );
+   issue( N(alice), N(alice), asset::from_string("1 NFT"), {"alice"}, "nft1", "alice token" );
+   produce_blocks(1);
+
+   auto small_cpu = transfer_cpu( N(alice), N(carol), "1 NFT" );
+
+   // Bob's tokens come before alice's in the symbol index,
+   // so a scan for alice's token would have to walk past all of them
+   BOOST_REQUIRE_EQUAL( success(), burn( N(alice), 10 ) );
+   for( auto i = 0; i < 4; i++ )
+   {
+      BOOST_REQUIRE_EQUAL( success(), issue_n( N(alice), N(bob), "NFT", 250 ) );
+      produce_blocks(1);
+   }
+   issue( N(alice), N(alice), asset::from_string("1 NFT"), {"alice"}, "nft1", "alice token" );
+   produce_blocks(1);
+
+   auto large_cpu = transfer_cpu( N(alice), N(carol), "1 NFT" );
+
+   // Billed CPU depends on the machine, so only a loose bound on the best
+   // of three runs is checked, a scan past 100 times more tokens breaks it
+   BOOST_TEST_MESSAGE( "transfer cpu with 10 other tokens: " << small_cpu << " us, with 1010: " << large_cpu << " us" );
+   BOOST_REQUIRE_LT( large_cpu, small_cpu * 3 );
+
+   auto alice_balance = get_account(N(alice), "0,NFT");
+   REQUIRE_MATCHING_OBJECT( alice_balance, mvo()
+      ("balance", "1 NFT")
+   );
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "token is not found or is not owned by account" ),
+      transfer( N(carol), N(alice), asset::from_string("1 NFT"), "carol owns no token" )
+   );
+
+   // The sender's own token moves, the 1000 tokens of bob before it stay put
+   BOOST_REQUIRE_EQUAL( success(), transfer( N(alice), N(carol), asset::from_string("1 NFT"), "by symbol" ) );
+   REQUIRE_MATCHING_OBJECT( get_token(1011), mvo()
+      ("id", "1011")
+      ("uri", "alice")
+      ("owner", "carol")
+      ("sym", "NFT")
+   );
+   REQUIRE_MATCHING_OBJECT( get_account(N(bob), "0,NFT"), mvo()
+      ("balance", "1010 NFT")
+   );
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( no_balances_tests, nft_tester ) try {
+
+   create( N(alice), string("NFT"));
+   create( N(alice), string("ART"));
+   produce_blocks(1);
+
+   auto setbalances = [&]( account_name signer, const string& sym, bool keep ) {
+      return push_action( signer, N(setbalances), mvo()
+           ( "sym", sym)
+           ( "keep", keep)
+      );
+   };
+
+   BOOST_REQUIRE_EQUAL( error( "missing authority of alice" ), setbalances( N(bob), "ART", false ) );
+   BOOST_REQUIRE_EQUAL( success(), setbalances( N(alice), "ART", false ) );
+
+   issue_n( N(alice), N(alice), "NFT", 10 );
+   issue_n( N(alice), N(alice), "ART", 10, "art1" );
+   produce_blocks(1);
+
+   // Fixed once tokens exist
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "balance mode can only change before tokens are issued" ),
+      setbalances( N(alice), "ART", true )
+   );
+
+   // Same transfer without the two balance row updates
+   auto balances_cpu = transfer_cpu( N(alice), N(bob), "1 NFT" );
+   auto no_balances_cpu = transfer_cpu( N(alice), N(bob), "1 ART" );
+   BOOST_TEST_MESSAGE( "transfer cpu with balances: " << balances_cpu << " us, without: " << no_balances_cpu << " us" );
+
+   BOOST_REQUIRE_EQUAL( success(), transferid( N(alice), N(bob), 12, "art" ) );
+   BOOST_REQUIRE_EQUAL( success(), transferids( N(alice), N(carol), {13, 14, 1}, "mixed" ) );
+   BOOST_REQUIRE_EQUAL( success(), burn( N(carol), 14 ) );
+
+   BOOST_REQUIRE_EQUAL( true, get_account(N(alice), "0,ART").is_null() );
+   BOOST_REQUIRE_EQUAL( true, get_account(N(bob), "0,ART").is_null() );
+   REQUIRE_MATCHING_OBJECT( get_account(N(carol), "0,NFT"), mvo()
+      ("balance", "1 NFT")
+   );
+   REQUIRE_MATCHING_OBJECT( get_stats("0,ART"), mvo()
+      ("supply", "9 ART")
+      ("issuer", "alice")
+   );
+   check_inventory( { "0,NFT", "0,ART" }, { N(alice), N(bob), N(carol) } );
+
+   // Balances are counted from the inventory instead
+   auto trace = push_action_trace( N(carol), N(balanceof), mvo()
+        ( "owner", "alice")
+        ( "sym", "ART")
+        ( "cursor", 0)
+        ( "limit", 100)
+   );
+   BOOST_REQUIRE_EQUAL( "7 ART\n", trace->action_traces[0].console );
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( migrate_tests, nft_tester ) try {
+
+   create( N(alice), string("NFT"));
+   produce_blocks(1);
+
+   issue_n( N(alice), N(alice), "NFT", 2 );
+
+   // Nothing left in the legacy table
+   BOOST_REQUIRE_EQUAL( success(),
+      push_action( N(eosio.nft), N(migrate), mvo()
+           ( "limit", 10)
+      )
+   );
+
+   REQUIRE_MATCHING_OBJECT( get_token(1), mvo()
+      ("id", "1")
+      ("uri", "uri1")
+      ("owner", "alice")
+      ("sym", "NFT")
+   );
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "limit must be positive" ),
+      push_action( N(eosio.nft), N(migrate), mvo()
+           ( "limit", 0)
+      )
+   );
+
+   BOOST_REQUIRE_EQUAL( error( "missing authority of eosio.nft" ),
+      push_action( N(alice), N(migrate), mvo()
+           ( "limit", 10)
+      )
+   );
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( migration_tests, nft_tester ) try {
+
+   create( N(alice), string("NFT"));
+   produce_blocks(1);
+
+   // Eight tokens of a deployment still in the legacy layout
+   auto nft_code = eosio::chain::symbol(0, "NFT").to_symbol_code().value;
+   for( id_type id = 0; id < 8; ++id )
+      store_legacy_token( id, "https://old.example/" + to_string(id), id < 5 ? N(alice) : N(bob), "1 NFT", id == 6 ? "other" : "nft1" );
+   store_row( nft_code, N(stat), nft_code, "stats", mvo()("supply", "8 NFT")("issuer", "alice") );
+   store_row( N(alice), N(accounts), nft_code, "account", mvo()("balance", "5 NFT") );
+   store_row( N(bob), N(accounts), nft_code, "account", mvo()("balance", "3 NFT") );
+   produce_blocks(1);
+
+   // Queries read legacy rows where they are, without converting them
+   auto& rlm = control->get_resource_limits_manager();
+   auto ram_before = rlm.get_account_ram_usage( N(eosio.nft) );
+   auto trace = push_action_trace( N(carol), N(ownerof), mvo()
+        ( "ids", vector<id_type>{ 0, 5, 8 } )
+   );
+   BOOST_REQUIRE_EQUAL( "0 alice\n5 bob\n8 \n", trace->action_traces[0].console );
+   BOOST_REQUIRE_EQUAL( 8, get_rows( N(eosio.nft), N(token), "legacy_token" ).size() );
+   BOOST_REQUIRE_EQUAL( ram_before, rlm.get_account_ram_usage( N(eosio.nft) ) );
+
+   auto migrate = [&]( uint64_t limit ) {
+      auto trace = push_action_trace( N(eosio.nft), N(migrate), mvo()( "limit", limit ) );
+      produce_blocks(1);
+      return trace->action_traces[0].console;
+   };
+
+   BOOST_REQUIRE_EQUAL( "next id: 2", migrate( 2 ) );
+   REQUIRE_MATCHING_OBJECT( get_migration(), mvo()
+      ("version", "0")
+      ("cursor", "2")
+   );
+
+   // Owner queries list the tokens not migrated yet after the inventory
+   auto tokensof = [&]( account_name owner, id_type cursor, uint64_t limit ) {
+      auto trace = push_action_trace( N(carol), N(tokensof), mvo()
+           ( "owner", owner)
+           ( "sym", "NFT")
+           ( "cursor", cursor)
+           ( "limit", limit)
+      );
+      produce_blocks(1);
+      return trace->action_traces[0].console;
+   };
+   BOOST_REQUIRE_EQUAL( "token: 0 NFT https://old.example/0\n"
+                        "token: 1 NFT https://old.example/1\n"
+                        "token: 2 NFT https://old.example/2\n"
+                        "next id: 3", tokensof( N(alice), 0, 3 ) );
+   BOOST_REQUIRE_EQUAL( "token: 3 NFT https://old.example/3\n"
+                        "token: 4 NFT https://old.example/4\n", tokensof( N(alice), 3, 3 ) );
+   trace = push_action_trace( N(carol), N(balanceof), mvo()
+        ( "owner", "alice")
+        ( "sym", "NFT")
+        ( "cursor", 0)
+        ( "limit", 100)
+   );
+   BOOST_REQUIRE_EQUAL( "5 NFT\n", trace->action_traces[0].console );
+   produce_blocks(1);
+
+   // setrampayers converts the payer's tokens and bills them to it
+   auto bob_before = rlm.get_account_ram_usage( N(bob) );
+   auto setrampayers = [&]( id_type cursor, uint64_t limit ) {
+      auto trace = push_action_trace( N(bob), N(setrampayers), mvo()
+           ( "payer", "bob")
+           ( "sym", "NFT")
+           ( "cursor", cursor)
+           ( "limit", limit)
+      );
+      produce_blocks(1);
+      return trace->action_traces[0].console;
+   };
+   BOOST_REQUIRE_EQUAL( "next id: 7", setrampayers( 0, 2 ) );
+   BOOST_REQUIRE_EQUAL( "", setrampayers( 7, 2 ) );
+   BOOST_REQUIRE_EQUAL( 3, get_rows( N(eosio.nft), N(token), "legacy_token" ).size() );
+   BOOST_REQUIRE_GT( rlm.get_account_ram_usage( N(bob) ), bob_before );
+
+   // Tokens not migrated yet are found by id and by owner between batches
+   BOOST_REQUIRE_EQUAL( success(), transferid( N(alice), N(carol), 3, "legacy" ) );
+   BOOST_REQUIRE_EQUAL( success(), transfer( N(bob), N(carol), asset::from_string("1 NFT"), "legacy" ) );
+   BOOST_REQUIRE_EQUAL( success(), burn( N(bob), 7 ) );
+
+   // New ids continue after the legacy ones
+   push_action( N(alice), N(setbaseuri), mvo()
+        ( "sym", "NFT")
+        ( "base_uri", "https://cdn.example/nft/")
+   );
+   BOOST_REQUIRE_EQUAL( success(), issue( N(alice), N(alice), asset::from_string("2 NFT"), {}, "nft1", "new" ) );
+   REQUIRE_MATCHING_OBJECT( get_range(8), mvo()
+      ("start", "8")
+      ("count", "2")
+      ("owner", "alice")
+      ("sym", "NFT")
+   );
+
+   BOOST_REQUIRE_EQUAL( "next id: 4", migrate( 1 ) );
+   BOOST_REQUIRE_EQUAL( success(), transfer( N(alice), N(bob), asset::from_string("1 NFT"), "migrated" ) );
+   BOOST_REQUIRE_EQUAL( "", migrate( 10 ) );
+
+   REQUIRE_MATCHING_OBJECT( get_migration(), mvo()
+      ("version", "1")
+      ("cursor", "0")
+   );
+   BOOST_REQUIRE_EQUAL( 0, get_rows( N(eosio.nft), N(token), "legacy_token" ).size() );
+   BOOST_REQUIRE_EQUAL( 1, get_rows( N(eosio.nft), N(tokennames), "tokenname" ).size() );
+   BOOST_REQUIRE_EQUAL( "", migrate( 10 ) );
+
+   // Legacy uris stay absolute under the base uri set during the migration
+   REQUIRE_MATCHING_OBJECT( get_token(3), mvo()
+      ("id", "3")
+      ("uri", "https://old.example/3")
+      ("owner", "carol")
+      ("sym", "NFT")
+   );
+   trace = push_action_trace( N(carol), N(ownerof), mvo()
+        ( "ids", vector<id_type>{ 0, 4, 5, 6, 7 } )
+   );
+   BOOST_REQUIRE_EQUAL( "0 bob\n4 alice\n5 carol\n6 bob\n7 \n", trace->action_traces[0].console );
+   trace = push_action_trace( N(carol), N(tokensof), mvo()
+        ( "owner", "carol")
+        ( "sym", "NFT")
+        ( "cursor", 0)
+        ( "limit", 10)
+   );
+   BOOST_REQUIRE_EQUAL( "token: 3 NFT https://old.example/3\n"
+                        "token: 5 NFT https://old.example/5\n", trace->action_traces[0].console );
+
+   REQUIRE_MATCHING_OBJECT( get_account(N(alice), "0,NFT"), mvo()
+      ("balance", "5 NFT")
+   );
+   REQUIRE_MATCHING_OBJECT( get_account(N(bob), "0,NFT"), mvo()
+      ("balance", "2 NFT")
+   );
+   REQUIRE_MATCHING_OBJECT( get_account(N(carol), "0,NFT"), mvo()
+      ("balance", "2 NFT")
+   );
+   REQUIRE_MATCHING_OBJECT( get_stats("0,NFT"), mvo()
+      ("supply", "9 NFT")
+      ("issuer", "alice")
+   );
+   check_inventory( { "0,NFT" }, { N(alice), N(bob), N(carol) } );
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( token_ram_tests, nft_tester ) try {
+
+   const uint32_t count = 50;
+   string long_name = "abcdefghijklmnopqrstuvwxyz012345";
+
+   create( N(alice), string("NFT"));
+   create( N(alice), string("ART"));
+   produce_blocks(1);
+
+   // First issue of each symbol stores its name in the collection row
+   issue( N(alice), N(alice), asset::from_string("1 NFT"), {"uri"}, "n", "first" );
+   issue( N(alice), N(alice), asset::from_string("1 ART"), {"uri"}, long_name, "first" );
+
+   REQUIRE_MATCHING_OBJECT( get_collection("0,ART"), mvo()
+      ("sym", "ART")
+      ("tokenName", long_name)
+      ("base_uri", "")
+      ("no_balances", "false")
+   );
+
+   // Later issues under another name keep it on their batch
+   BOOST_REQUIRE_EQUAL( success(), issue( N(alice), N(alice), asset::from_string("1 NFT"), {"uri"}, "other", "hola" ) );
+   REQUIRE_MATCHING_OBJECT( get_batch(2), mvo()
+      ("start", "2")
+      ("count", "1")
+      ("sym", "NFT")
+      ("tokenName", "other")
+   );
+   REQUIRE_MATCHING_OBJECT( get_collection("0,NFT"), mvo()
+      ("sym", "NFT")
+      ("tokenName", "n")
+      ("base_uri", "")
+      ("no_balances", "false")
+   );
+
+   auto& rlm = control->get_resource_limits_manager();
+
+   auto ram_before = rlm.get_account_ram_usage( N(alice) );
+   issue_n( N(alice), N(alice), "NFT", count, "n" );
+   auto short_name_bytes = rlm.get_account_ram_usage( N(alice) ) - ram_before;
+
+   ram_before = rlm.get_account_ram_usage( N(alice) );
+   issue_n( N(alice), N(alice), "ART", count, long_name );
+   auto long_name_bytes = rlm.get_account_ram_usage( N(alice) ) - ram_before;
+
+   BOOST_TEST_MESSAGE( "RAM per token: " << short_name_bytes / count << " bytes with a 1 byte name, "
+                       << long_name_bytes / count << " bytes with a 32 byte name (legacy layout: "
+                       << long_name_bytes / count + 8 + 1 + long_name.size() << " bytes)" );
+
+   // Name length does not change the per-token cost
+   BOOST_REQUIRE_EQUAL( short_name_bytes, long_name_bytes );
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( transferid_tests, nft_tester ) try {
+
+   auto token = create( N(alice), string("NFT"));
+   produce_blocks(1);
+
+   vector<string> uris = {"uri", "uri2", "uri3"};
+
+   issue( N(alice), N(alice), asset::from_string("3 NFT"), uris, "nft1", "hola" );
+
+   transferid( N(alice), N(bob), 0, "send token 0 to bob" );
+
+
+   transferid( N(alice), N(bob), 1, "send token 1 to bob" );
+
+
+   auto alice_balance = get_account(N(alice), "0,NFT");
    REQUIRE_MATCHING_OBJECT( alice_balance, mvo()
       ("balance", "1 NFT")
    );
@@ -375,8 +1431,7 @@ BOOST_FIXTURE_TEST_CASE( transferid_tests, nft_tester ) try {
         ("id", "1")
         ("uri", "uri2")
 	("owner", "bob")
-	("value", "1 NFT")
-	("tokenName", "nft1")
+	("sym", "NFT")
    );
 
    transferid(N(bob), N(carol), 1, "send token 1 to carol");
@@ -396,8 +1451,7 @@ BOOST_FIXTURE_TEST_CASE( transferid_tests, nft_tester ) try {
       	("id", "1")
       	("uri", "uri2")
 	("owner", "carol")
-	("value", "1 NFT")
-	("tokenName", "nft1")
+	("sym", "NFT")
    );
 
    BOOST_REQUIRE_EQUAL( wasm_assert_msg( "sender does not own token with specified ID" ),
@@ -429,6 +1483,782 @@ BOOST_FIXTURE_TEST_CASE( transferid_tests, nft_tester ) try {
 
 } FC_LOG_AND_RETHROW()
 
+BOOST_FIXTURE_TEST_CASE( transferids_tests, nft_tester ) try {
+
+   create( N(alice), string("NFT"));
+   create( N(alice), string("ART"));
+   produce_blocks(1);
+
+   issue( N(alice), N(alice), asset::from_string("3 NFT"), {"uri", "uri2", "uri3"}, "nft1", "hola" );
+   issue( N(alice), N(alice), asset::from_string("2 ART"), {"art", "art2"}, "art1", "hola" );
+
+   auto trace = push_action_trace( N(alice), N(transferids), mvo()
+        ( "from", "alice")
+        ( "to", "bob")
+        ( "ids", vector<id_type>{0, 2, 3})
+        ( "memo", "send 3 tokens to bob")
+   );
+   BOOST_REQUIRE_EQUAL( 1, notifications( trace, N(alice) ) );
+   BOOST_REQUIRE_EQUAL( 1, notifications( trace, N(bob) ) );
+
+   REQUIRE_MATCHING_OBJECT( get_account(N(alice), "0,NFT"), mvo()
+      ("balance", "1 NFT")
+   );
+   REQUIRE_MATCHING_OBJECT( get_account(N(alice), "0,ART"), mvo()
+      ("balance", "1 ART")
+   );
+   REQUIRE_MATCHING_OBJECT( get_account(N(bob), "0,NFT"), mvo()
+      ("balance", "2 NFT")
+   );
+   REQUIRE_MATCHING_OBJECT( get_account(N(bob), "0,ART"), mvo()
+      ("balance", "1 ART")
+   );
+
+   REQUIRE_MATCHING_OBJECT( get_token(3, "0,ART"), mvo()
+      ("id", "3")
+      ("uri", "art")
+      ("owner", "bob")
+      ("sym", "ART")
+   );
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "sender does not own token with specified ID" ),
+      transferids( N(alice), N(carol), {1, 0}, "0 is owned by bob" )
+   );
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "sender does not own token with specified ID" ),
+      transferids( N(alice), N(carol), {1, 1}, "same id twice" )
+   );
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "token with specified ID does not exist" ),
+      transferids( N(alice), N(carol), {1, 10}, "no token id" )
+   );
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "no token ids provided" ),
+      transferids( N(alice), N(carol), {}, "empty" )
+   );
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "cannot transfer to self" ),
+      transferids( N(alice), N(alice), {1}, "send to self" )
+   );
+
+   // Failed batches leave ownership untouched
+   REQUIRE_MATCHING_OBJECT( get_account(N(alice), "0,NFT"), mvo()
+      ("balance", "1 NFT")
+   );
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( swap_tests, nft_tester ) try {
+
+   create( N(alice), string("NFT"));
+   create( N(alice), string("ART"));
+   produce_blocks(1);
+
+   issue( N(alice), N(alice), asset::from_string("2 NFT"), {"a", "b"}, "nft1", "hola" );
+   issue( N(alice), N(bob), asset::from_string("1 NFT"), {"c"}, "nft1", "hola" );
+   issue( N(alice), N(carol), asset::from_string("2 ART"), {"d", "e"}, "art1", "hola" );
+
+   // Every leg is checked against the state before the swap
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "token listed in more than one leg" ),
+      swap( { N(alice), N(bob) }, { {N(alice), N(bob), 0}, {N(bob), N(carol), 0} }, "pass on" )
+   );
+   BOOST_REQUIRE_EQUAL( error( "missing authority of bob" ),
+      swap( { N(alice) }, { {N(alice), N(bob), 0}, {N(bob), N(alice), 2} }, "bob did not sign" )
+   );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "sender does not own token with specified ID" ),
+      swap( { N(alice), N(bob) }, { {N(alice), N(bob), 0}, {N(bob), N(alice), 3} }, "3 is carol's" )
+   );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "no swap legs provided" ), swap( { N(alice) }, {}, "empty" ) );
+
+   // Round robin, nobody's balance changes
+   BOOST_REQUIRE_EQUAL( success(),
+      swap( { N(alice), N(bob), N(carol) }, { {N(alice), N(bob), 0}, {N(bob), N(carol), 2}, {N(carol), N(alice), 3} }, "round robin" )
+   );
+   BOOST_REQUIRE_EQUAL( "bob", get_token(0)["owner"].as_string() );
+   BOOST_REQUIRE_EQUAL( "carol", get_token(2)["owner"].as_string() );
+   BOOST_REQUIRE_EQUAL( "alice", get_token(3, "0,ART")["owner"].as_string() );
+   REQUIRE_MATCHING_OBJECT( get_account(N(alice), "0,NFT"), mvo()
+      ("balance", "1 NFT")
+   );
+   REQUIRE_MATCHING_OBJECT( get_account(N(alice), "0,ART"), mvo()
+      ("balance", "1 ART")
+   );
+   REQUIRE_MATCHING_OBJECT( get_account(N(carol), "0,NFT"), mvo()
+      ("balance", "1 NFT")
+   );
+
+   // Bundle trade, alice's NFT balance is left as it is
+   BOOST_REQUIRE_EQUAL( success(),
+      swap( { N(alice), N(bob) }, { {N(alice), N(bob), 1}, {N(alice), N(bob), 3}, {N(bob), N(alice), 0} }, "bundle" )
+   );
+   REQUIRE_MATCHING_OBJECT( get_account(N(bob), "0,NFT"), mvo()
+      ("balance", "1 NFT")
+   );
+   REQUIRE_MATCHING_OBJECT( get_account(N(bob), "0,ART"), mvo()
+      ("balance", "1 ART")
+   );
+   REQUIRE_MATCHING_OBJECT( get_account(N(alice), "0,NFT"), mvo()
+      ("balance", "1 NFT")
+   );
+   BOOST_REQUIRE_EQUAL( true, get_account(N(alice), "0,ART").is_null() );
+
+   check_inventory( { "0,NFT", "0,ART" }, { N(alice), N(bob), N(carol) } );
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( hash_token_tests, nft_tester ) try {
+
+   create( N(alice), string("NFT"));
+   produce_blocks(1);
+
+   const string hash1 = "0101010101010101010101010101010101010101010101010101010101010101";
+   const string hash2 = "02020202020202020202020202020202020202020202020202020202020202ff";
+   auto issuehash = [&]( account_name to, const string& quantity, vector<string> hashes ) {
+      return push_action( N(alice), N(issuehash), mvo()
+           ( "to", to)
+           ( "quantity", quantity)
+           ( "hashes", hashes)
+           ( "name", "nft1")
+           ( "memo", "by hash")
+      );
+   };
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "base uri must be set to issue tokens by hash" ),
+      issuehash( N(alice), "1 NFT", { hash1 } )
+   );
+
+   push_action( N(alice), N(setbaseuri), mvo()
+        ( "sym", "NFT")
+        ( "base_uri", "https://{hash}.ipfs.example/")
+   );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "mismatch between number of tokens and hashes provided" ),
+      issuehash( N(alice), "2 NFT", { hash1 } )
+   );
+
+   // A content-addressed token costs less RAM than the same token with its uri
+   auto& rlm = control->get_resource_limits_manager();
+   auto ram = rlm.get_account_ram_usage( N(alice) );
+   BOOST_REQUIRE_EQUAL( success(), issuehash( N(alice), "1 NFT", { hash1 } ) );
+   auto hash_ram = rlm.get_account_ram_usage( N(alice) ) - ram;
+
+   ram = rlm.get_account_ram_usage( N(alice) );
+   issue( N(alice), N(alice), asset::from_string("1 NFT"), {"bafybeigdyrzt5sfp7udm7hu76uh7y26nf3efuylqabf3oclgtqy55fbzdi"}, "nft1", "by uri" );
+   auto uri_ram = rlm.get_account_ram_usage( N(alice) ) - ram;
+   BOOST_REQUIRE( hash_ram < uri_ram );
+
+   BOOST_REQUIRE_EQUAL( success(), issuehash( N(alice), "1 NFT", { hash2 } ) );
+   auto rows = get_rows( eosio::chain::symbol::from_string("0,NFT").to_symbol_code().value, N(hashtokens), "hashtoken" );
+   BOOST_REQUIRE_EQUAL( 2, rows.size() );
+   REQUIRE_MATCHING_OBJECT( rows[1], mvo()
+      ("id", "2")
+      ("content_hash", hash2)
+      ("owner", "alice")
+      ("sym", "NFT")
+   );
+
+   // Hashed tokens move and burn like any other token
+   BOOST_REQUIRE_EQUAL( success(), transferid( N(alice), N(bob), 0, "by id" ) );
+   BOOST_REQUIRE_EQUAL( success(), transferids( N(alice), N(carol), {1, 2}, "mixed" ) );
+   BOOST_REQUIRE_EQUAL( success(), transfer( N(bob), N(carol), asset::from_string("1 NFT"), "by symbol" ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "sender does not own token with specified ID" ),
+      transferid( N(alice), N(bob), 2, "not alice's" )
+   );
+   REQUIRE_MATCHING_OBJECT( get_account(N(carol), "0,NFT"), mvo()
+      ("balance", "3 NFT")
+   );
+
+   BOOST_REQUIRE_EQUAL( success(), push_action( N(carol), N(setrampayer), mvo()( "payer", "carol")( "id", 2 ) ) );
+   BOOST_REQUIRE_EQUAL( success(), burn( N(carol), 0 ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "token with id does not exist" ), burn( N(carol), 0 ) );
+   BOOST_REQUIRE_EQUAL( 1, get_rows( eosio::chain::symbol::from_string("0,NFT").to_symbol_code().value, N(hashtokens), "hashtoken" ).size() );
+
+   check_inventory( { "0,NFT" }, { N(alice), N(bob), N(carol) } );
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( symbol_scope_tests, nft_tester ) try {
+
+   create( N(alice), string("NFT"));
+   create( N(alice), string("ART"));
+   produce_blocks(1);
+
+   issue( N(alice), N(alice), asset::from_string("2 NFT"), {"n0", "n1"}, "nft1", "hola" );
+   issue( N(alice), N(alice), asset::from_string("1 NFT"), {"n2"}, "nft1", "hola" );
+   issue( N(alice), N(bob), asset::from_string("2 ART"), {"a3", "a4"}, "art1", "hola" );
+
+   // Consecutive batches of one symbol share a directory record
+   REQUIRE_MATCHING_OBJECT( get_batch(0), mvo()
+      ("start", "0")
+      ("count", "3")
+      ("sym", "NFT")
+      ("tokenName", "")
+   );
+   REQUIRE_MATCHING_OBJECT( get_batch(3), mvo()
+      ("start", "3")
+      ("count", "2")
+      ("sym", "ART")
+      ("tokenName", "")
+   );
+
+   // Each symbol keeps its tokens in its own scope
+   BOOST_REQUIRE_EQUAL( true, get_row_by_account( N(eosio.nft), eosio::chain::symbol(0, "ART").to_symbol_code().value, N(tokens), 0 ).empty() );
+   BOOST_REQUIRE_EQUAL( true, get_row_by_account( N(eosio.nft), eosio::chain::symbol(0, "NFT").to_symbol_code().value, N(tokens), 3 ).empty() );
+
+   // Ids stay global so id-only actions still address any token
+   BOOST_REQUIRE_EQUAL( success(), transferid( N(bob), N(carol), 4, "art to carol" ) );
+   BOOST_REQUIRE_EQUAL( success(), transferids( N(alice), N(carol), {1, 2}, "nft to carol" ) );
+
+   REQUIRE_MATCHING_OBJECT( get_token(4, "0,ART"), mvo()
+      ("id", "4")
+      ("uri", "a4")
+      ("owner", "carol")
+      ("sym", "ART")
+   );
+   REQUIRE_MATCHING_OBJECT( get_account(N(carol), "0,NFT"), mvo()
+      ("balance", "2 NFT")
+   );
+
+   // Symbol transfers only look at the owner index of that symbol
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "token is not found or is not owned by account" ),
+      transfer( N(bob), N(alice), asset::from_string("1 NFT"), "bob owns only art" )
+   );
+   BOOST_REQUIRE_EQUAL( success(), transfer( N(bob), N(alice), asset::from_string("1 ART"), "art back" ) );
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "token with specified ID does not exist" ),
+      transferid( N(alice), N(bob), 5, "never issued" )
+   );
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( inventory_tests, nft_tester ) try {
+
+   const vector<string> symbols = { "0,NFT", "0,ART" };
+   const vector<account_name> owners = { N(alice), N(bob), N(carol) };
+
+   create( N(alice), string("NFT"));
+   create( N(alice), string("ART"));
+   produce_blocks(1);
+
+   push_action( N(alice), N(setbaseuri), mvo()
+        ( "sym", "ART")
+        ( "base_uri", "https://cdn.example/art/")
+   );
+
+   BOOST_REQUIRE_EQUAL( success(), issue( N(alice), N(alice), asset::from_string("3 NFT"), {"n0", "n1", "n2"}, "nft1", "hola" ) );
+   check_inventory( symbols, owners );
+   BOOST_REQUIRE_EQUAL( success(), issue( N(alice), N(bob), asset::from_string("10 ART"), {}, "art1", "range" ) );
+   check_inventory( symbols, owners );
+
+   // A wallet lists its tokens from its own scope
+   auto bob_inventory = get_rows( N(bob).value, N(inventory), "holding" );
+   BOOST_REQUIRE_EQUAL( 1, bob_inventory.size() );
+   REQUIRE_MATCHING_OBJECT( bob_inventory[0], mvo()
+      ("id", "3")
+      ("count", "10")
+      ("sym", "ART")
+   );
+
+   BOOST_REQUIRE_EQUAL( success(), transferid( N(alice), N(bob), 1, "nft to bob" ) );
+   check_inventory( symbols, owners );
+   BOOST_REQUIRE_EQUAL( success(), transferid( N(bob), N(carol), 7, "from the middle of a range" ) );
+   check_inventory( symbols, owners );
+   BOOST_REQUIRE_EQUAL( success(), transfer( N(bob), N(alice), asset::from_string("1 ART"), "start of a range" ) );
+   check_inventory( symbols, owners );
+   BOOST_REQUIRE_EQUAL( success(), transfer( N(alice), N(carol), asset::from_string("1 NFT"), "by symbol" ) );
+   check_inventory( symbols, owners );
+   BOOST_REQUIRE_EQUAL( success(), transferids( N(bob), N(carol), {1, 12, 8}, "mixed" ) );
+   check_inventory( symbols, owners );
+   BOOST_REQUIRE_EQUAL( success(),
+      push_action( N(carol), N(setrampayer), mvo()
+           ( "payer", "carol")
+           ( "id", 12)
+      )
+   );
+   check_inventory( symbols, owners );
+   BOOST_REQUIRE_EQUAL( success(), burn( N(carol), 7 ) );
+   check_inventory( symbols, owners );
+   BOOST_REQUIRE_EQUAL( success(), burn( N(bob), 5 ) );
+   check_inventory( symbols, owners );
+   BOOST_REQUIRE_EQUAL( success(), burnids( N(carol), {0, 8} ) );
+   check_inventory( symbols, owners );
+
+   // Failed actions leave every inventory untouched
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "sender does not own token with specified ID" ),
+      transferids( N(bob), N(alice), {4, 12}, "12 is carol's" )
+   );
+   check_inventory( symbols, owners );
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( token_metadata_tests, nft_tester ) try {
+
+   create( N(alice), string("NFT"));
+   produce_blocks(1);
+
+   push_action( N(alice), N(setbaseuri), mvo()
+        ( "sym", "NFT")
+        ( "base_uri", "https://cdn.example/nft/")
+   );
+
+   auto nft_code = eosio::chain::symbol(0, "NFT").to_symbol_code().value;
+   issue( N(alice), N(alice), asset::from_string("2 NFT"), {"a.json", "b.json"}, "nft1", "hola" );
+   issue( N(alice), N(alice), asset::from_string("3 NFT"), {}, "nft1", "range" );
+
+   // Token rows are fixed size, the uri is on a metadata row of its own
+   auto hot = get_row_by_account( N(eosio.nft), nft_code, N(tokens), 0 );
+   BOOST_REQUIRE_EQUAL( 24, hot.size() );
+   auto cold = get_row_by_account( N(eosio.nft), nft_code, N(tokenmeta), 0 );
+   BOOST_REQUIRE_EQUAL( false, cold.empty() );
+
+   // Ownership changes only write the token row
+   BOOST_REQUIRE_EQUAL( success(), transferid( N(alice), N(bob), 0, "hot" ) );
+   BOOST_REQUIRE_EQUAL( success(), push_action( N(bob), N(setrampayer), mvo()( "payer", "bob")( "id", 0 ) ) );
+   BOOST_REQUIRE( cold == get_row_by_account( N(eosio.nft), nft_code, N(tokenmeta), 0 ) );
+   REQUIRE_MATCHING_OBJECT( get_token(0), mvo()
+      ("id", "0")
+      ("uri", "a.json")
+      ("owner", "bob")
+      ("sym", "NFT")
+   );
+
+   // Tokens issued without uri never get a metadata row
+   BOOST_REQUIRE_EQUAL( success(), transferid( N(alice), N(bob), 3, "from a range" ) );
+   BOOST_REQUIRE_EQUAL( 24, get_row_by_account( N(eosio.nft), nft_code, N(tokens), 3 ).size() );
+   BOOST_REQUIRE_EQUAL( 2, get_rows( nft_code, N(tokenmeta), "tokenmeta" ).size() );
+
+   // Burning the token removes its metadata
+   BOOST_REQUIRE_EQUAL( success(), burn( N(bob), 0 ) );
+   BOOST_REQUIRE_EQUAL( true, get_row_by_account( N(eosio.nft), nft_code, N(tokenmeta), 0 ).empty() );
+   BOOST_REQUIRE_EQUAL( 1, get_rows( nft_code, N(tokenmeta), "tokenmeta" ).size() );
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( setrampayers_tests, nft_tester ) try {
+
+   create( N(alice), string("NFT"));
+   create( N(alice), string("ART"));
+   produce_blocks(1);
+
+   push_action( N(alice), N(setbaseuri), mvo()
+        ( "sym", "NFT")
+        ( "base_uri", "https://cdn.example/nft/")
+   );
+
+   issue_n( N(alice), N(bob), "NFT", 20 );
+   issue_n( N(alice), N(bob), "ART", 5 );
+   issue( N(alice), N(bob), asset::from_string("1000 NFT"), {}, "nft1", "range" );
+   produce_blocks(1);
+
+   auto& rlm = control->get_resource_limits_manager();
+   auto alice_before = rlm.get_account_ram_usage( N(alice) );
+   auto nft_before = rlm.get_account_ram_usage( N(eosio.nft) );
+   auto bob_before = rlm.get_account_ram_usage( N(bob) );
+
+   auto setrampayers = [&]( id_type cursor, uint64_t limit ) {
+      return push_action_trace( N(bob), N(setrampayers), mvo()
+           ( "payer", "bob")
+           ( "sym", "NFT")
+           ( "cursor", cursor)
+           ( "limit", limit)
+      );
+   };
+
+   // The walk stops after "limit" inventory entries and prints where to go on
+   auto trace = setrampayers( 0, 15 );
+   BOOST_REQUIRE_EQUAL( "next id: 15", trace->action_traces[0].console );
+   produce_blocks(1);
+
+   // ART tokens are skipped, the NFT range is rebilled as one record
+   trace = setrampayers( 15, 15 );
+   BOOST_REQUIRE_EQUAL( "", trace->action_traces[0].console );
+   produce_blocks(1);
+
+   // Every NFT row moved to bob, the ART rows stayed with alice. The balance
+   // row was last written by the contract, so part of it comes from eosio.nft
+   auto moved = ( alice_before - rlm.get_account_ram_usage( N(alice) ) )
+              + ( nft_before - rlm.get_account_ram_usage( N(eosio.nft) ) );
+   BOOST_REQUIRE( alice_before > rlm.get_account_ram_usage( N(alice) ) );
+   BOOST_REQUIRE_EQUAL( moved, rlm.get_account_ram_usage( N(bob) ) - bob_before );
+
+   alice_before = rlm.get_account_ram_usage( N(alice) );
+   trace = push_action_trace( N(bob), N(setrampayers), mvo()
+        ( "payer", "bob")
+        ( "sym", "ART")
+        ( "cursor", 0)
+        ( "limit", 100)
+   );
+   BOOST_REQUIRE( alice_before > rlm.get_account_ram_usage( N(alice) ) );
+   produce_blocks(1);
+
+   // Nothing left to take over
+   alice_before = rlm.get_account_ram_usage( N(alice) );
+   setrampayers( 0, 100 );
+   BOOST_REQUIRE_EQUAL( alice_before, rlm.get_account_ram_usage( N(alice) ) );
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "limit must be positive" ),
+      push_action( N(bob), N(setrampayers), mvo()
+           ( "payer", "bob")
+           ( "sym", "NFT")
+           ( "cursor", 0)
+           ( "limit", 0)
+      )
+   );
+   BOOST_REQUIRE_EQUAL( error( "missing authority of bob" ),
+      push_action( N(alice), N(setrampayers), mvo()
+           ( "payer", "bob")
+           ( "sym", "NFT")
+           ( "cursor", 0)
+           ( "limit", 10)
+      )
+   );
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( approval_tests, nft_tester ) try {
+
+   create( N(alice), string("NFT"));
+   produce_blocks(1);
+
+   push_action( N(alice), N(setbaseuri), mvo()
+        ( "sym", "NFT")
+        ( "base_uri", "https://cdn.example/nft/")
+   );
+   issue( N(alice), N(alice), asset::from_string("3 NFT"), {"a", "b", "c"}, "nft1", "hola" );
+   issue( N(alice), N(bob), asset::from_string("10 NFT"), {}, "nft1", "range" );
+
+   auto setapproval = [&]( account_name owner, id_type id, account_name spender ) {
+      return push_action( owner, N(setapproval), mvo()
+           ( "owner", owner)
+           ( "id", id)
+           ( "spender", spender)
+      );
+   };
+   auto approveall = [&]( account_name owner, account_name spender, bool approved ) {
+      return push_action( owner, N(approveall), mvo()
+           ( "owner", owner)
+           ( "spender", spender)
+           ( "approved", approved)
+      );
+   };
+
+   BOOST_REQUIRE_EQUAL( error( "missing authority of alice" ),
+      push_action( N(market), N(transferid), mvo()
+           ( "from", "alice")
+           ( "to", "carol")
+           ( "id", 0)
+           ( "memo", "not approved")
+      )
+   );
+
+   // Approval for a single token, also for tokens of a range
+   BOOST_REQUIRE_EQUAL( success(), setapproval( N(alice), 0, N(market) ) );
+   BOOST_REQUIRE_EQUAL( success(), setapproval( N(bob), 5, N(market) ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "sender does not own token with specified ID" ),
+      setapproval( N(alice), 5, N(market) )
+   );
+
+   BOOST_REQUIRE_EQUAL( success(),
+      push_action( N(market), N(transferid), mvo()
+           ( "from", "alice")
+           ( "to", "carol")
+           ( "id", 0)
+           ( "memo", "fill")
+      )
+   );
+   BOOST_REQUIRE_EQUAL( success(),
+      push_action( N(market), N(transferids), mvo()
+           ( "from", "bob")
+           ( "to", "carol")
+           ( "ids", vector<id_type>{5})
+           ( "memo", "fill")
+      )
+   );
+
+   // Approvals end with the ownership
+   BOOST_REQUIRE_EQUAL( true, get_row_by_account( N(eosio.nft), N(eosio.nft), N(approvals), 0 ).empty() );
+   BOOST_REQUIRE_EQUAL( error( "missing authority of carol" ),
+      push_action( N(market), N(transferid), mvo()
+           ( "from", "carol")
+           ( "to", "alice")
+           ( "id", 0)
+           ( "memo", "approval is gone")
+      )
+   );
+
+   // Operators move every token of the owner
+   BOOST_REQUIRE_EQUAL( success(), approveall( N(alice), N(market), true ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "operator is already approved" ), approveall( N(alice), N(market), true ) );
+
+   BOOST_REQUIRE_EQUAL( success(),
+      push_action( N(market), N(transfer), mvo()
+           ( "from", "alice")
+           ( "to", "carol")
+           ( "quantity", "1 NFT")
+           ( "memo", "by symbol")
+      )
+   );
+   BOOST_REQUIRE_EQUAL( success(),
+      push_action( N(market), N(transferid), mvo()
+           ( "from", "alice")
+           ( "to", "bob")
+           ( "id", 2)
+           ( "memo", "by id")
+      )
+   );
+
+   REQUIRE_MATCHING_OBJECT( get_account(N(carol), "0,NFT"), mvo()
+      ("balance", "3 NFT")
+   );
+   BOOST_REQUIRE_EQUAL( true, get_account(N(alice), "0,NFT").is_null() );
+
+   BOOST_REQUIRE_EQUAL( success(), approveall( N(alice), N(market), false ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "operator is not approved" ), approveall( N(alice), N(market), false ) );
+   BOOST_REQUIRE_EQUAL( error( "missing authority of bob" ),
+      push_action( N(market), N(transferid), mvo()
+           ( "from", "bob")
+           ( "to", "alice")
+           ( "id", 2)
+           ( "memo", "never approved by bob")
+      )
+   );
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "spender account does not exist" ), approveall( N(bob), N(dummy), true ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "cannot approve owner" ), setapproval( N(bob), 2, N(bob) ) );
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( transferids_payer_tests, nft_tester ) try {
+
+   create( N(alice), string("NFT"));
+   create( N(alice), string("ART"));
+   produce_blocks(1);
+
+   issue( N(alice), N(alice), asset::from_string("1 NFT"), {"a"}, "nft1", "hola" );
+   issue( N(alice), N(alice), asset::from_string("1 ART"), {"b"}, "art1", "hola" );
+
+   // A different spender is approved for each token
+   for( auto approval : { std::make_pair( 0, string("market") ), std::make_pair( 1, string("carol") ) } )
+      BOOST_REQUIRE_EQUAL( success(), push_action( N(alice), N(setapproval), mvo()
+           ( "owner", "alice")
+           ( "id", approval.first)
+           ( "spender", approval.second)
+      ) );
+
+   auto& rlm = control->get_resource_limits_manager();
+   auto market_before = rlm.get_account_ram_usage( N(market) );
+   auto carol_before = rlm.get_account_ram_usage( N(carol) );
+
+   BOOST_REQUIRE_EQUAL( success(),
+      push_signed_action( { N(market), N(carol) }, N(transferids), mvo()
+           ( "from", "alice")
+           ( "to", "bob")
+           ( "ids", vector<id_type>{ 0, 1 })
+           ( "memo", "two spenders")
+      )
+   );
+
+   // Each spender pays for the rows of its own token, including
+   // bob's balance row of that token's symbol
+   auto market_bytes = rlm.get_account_ram_usage( N(market) ) - market_before;
+   auto carol_bytes = rlm.get_account_ram_usage( N(carol) ) - carol_before;
+   BOOST_REQUIRE_EQUAL( market_bytes, carol_bytes );
+   BOOST_REQUIRE_GT( market_bytes, 0 );
+
+   REQUIRE_MATCHING_OBJECT( get_account(N(bob), "0,ART"), mvo()
+      ("balance", "1 ART")
+   );
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( approval_inline_tests, nft_tester ) try {
+
+   create( N(alice), string("NFT"));
+   produce_blocks(1);
+
+   issue( N(alice), N(alice), asset::from_string("2 NFT"), {"a", "b"}, "nft1", "hola" );
+   BOOST_REQUIRE_EQUAL( success(), push_action( N(alice), N(setapproval), mvo()
+        ( "owner", "alice")
+        ( "id", 0)
+        ( "spender", "market")
+   ) );
+
+   // A marketplace contract settles a trade started by carol, the
+   // approved spender is the authorizer of the inline transfer only
+   set_inline_caller( N(market), N(transferid), mvo()
+        ( "from", "alice")
+        ( "to", "carol")
+        ( "id", 0)
+        ( "memo", "inline")
+   );
+
+   action buy;
+   buy.account = N(market);
+   buy.name    = N(buy);
+   buy.authorization.push_back( permission_level{ N(carol), config::active_name } );
+   BOOST_REQUIRE_EQUAL( success(), base_tester::push_action( std::move(buy), uint64_t(N(carol)) ) );
+
+   auto trace = push_action_trace( N(carol), N(ownerof), mvo()
+        ( "ids", vector<id_type>{ 0, 1 } )
+   );
+   BOOST_REQUIRE_EQUAL( "0 carol\n1 alice\n", trace->action_traces[0].console );
+
+   // Token 1 is not approved, the same call fails
+   set_inline_caller( N(market), N(transferid), mvo()
+        ( "from", "alice")
+        ( "to", "carol")
+        ( "id", 1)
+        ( "memo", "inline")
+   );
+
+   action again;
+   again.account = N(market);
+   again.name    = N(buy);
+   again.authorization.push_back( permission_level{ N(carol), config::active_name } );
+   BOOST_REQUIRE_EQUAL( error( "missing authority of alice" ),
+      base_tester::push_action( std::move(again), uint64_t(N(carol)) )
+   );
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( changelog_tests, nft_tester ) try {
+
+   create( N(alice), string("NFT"));
+   produce_blocks(1);
+
+   push_action( N(alice), N(setbaseuri), mvo()
+        ( "sym", "NFT")
+        ( "base_uri", "https://cdn.example/nft/")
+   );
+
+   // Nothing is logged until the contract sets a window
+   issue( N(alice), N(alice), asset::from_string("2 NFT"), {"a", "b"}, "nft1", "hola" );
+   BOOST_REQUIRE_EQUAL( 0, get_rows( N(eosio.nft).value, N(changes), "change" ).size() );
+
+   BOOST_REQUIRE_EQUAL( error( "missing authority of eosio.nft" ),
+      push_action( N(alice), N(setlogwindow), mvo()( "window", 4 ) )
+   );
+   BOOST_REQUIRE_EQUAL( success(), push_action( N(eosio.nft), N(setlogwindow), mvo()( "window", 4 ) ) );
+
+   issue( N(alice), N(bob), asset::from_string("10 NFT"), {}, "nft1", "range" );
+   auto changes = get_rows( N(eosio.nft).value, N(changes), "change" );
+   BOOST_REQUIRE_EQUAL( 1, changes.size() );
+   REQUIRE_MATCHING_OBJECT( changes[0], mvo()
+      ("seq", "0")
+      ("id", "2")
+      ("count", "10")
+      ("op", "mint")
+      ("from", "")
+      ("to", "bob")
+   );
+
+   BOOST_REQUIRE_EQUAL( success(), transferid( N(alice), N(bob), 0, "log" ) );
+   BOOST_REQUIRE_EQUAL( success(), transferids( N(bob), N(carol), {0, 5}, "log" ) );
+   BOOST_REQUIRE_EQUAL( success(), push_action( N(carol), N(setrampayer), mvo()( "payer", "carol")( "id", 5 ) ) );
+   BOOST_REQUIRE_EQUAL( success(), burn( N(carol), 5 ) );
+
+   // Only the last 4 changes are kept
+   changes = get_rows( N(eosio.nft).value, N(changes), "change" );
+   BOOST_REQUIRE_EQUAL( 4, changes.size() );
+   REQUIRE_MATCHING_OBJECT( changes[0], mvo()
+      ("seq", "2")
+      ("id", "0")
+      ("count", "1")
+      ("op", "transfer")
+      ("from", "bob")
+      ("to", "carol")
+   );
+   REQUIRE_MATCHING_OBJECT( changes[3], mvo()
+      ("seq", "5")
+      ("id", "5")
+      ("count", "1")
+      ("op", "burn")
+      ("from", "carol")
+      ("to", "")
+   );
+
+   // Batch payer changes are logged per inventory entry
+   BOOST_REQUIRE_EQUAL( success(), push_action( N(bob), N(setrampayers), mvo()
+        ( "payer", "bob")
+        ( "sym", "NFT")
+        ( "cursor", 0)
+        ( "limit", 10)
+   ) );
+   changes = get_rows( N(eosio.nft).value, N(changes), "change" );
+   BOOST_REQUIRE_EQUAL( 4, changes.size() );
+   REQUIRE_MATCHING_OBJECT( changes[3], mvo()
+      ("seq", "7")
+      ("id", "6")
+      ("count", "6")
+      ("op", "rampayer")
+      ("from", "bob")
+      ("to", "bob")
+   );
+
+   // A smaller window drops the changes that left it right away
+   BOOST_REQUIRE_EQUAL( success(), push_action( N(eosio.nft), N(setlogwindow), mvo()( "window", 2 ) ) );
+   changes = get_rows( N(eosio.nft).value, N(changes), "change" );
+   BOOST_REQUIRE_EQUAL( 2, changes.size() );
+   BOOST_REQUIRE_EQUAL( "6", changes[0]["seq"].as_string() );
+
+   // Turning the log off drops every change and keeps the sequence
+   BOOST_REQUIRE_EQUAL( success(), push_action( N(eosio.nft), N(setlogwindow), mvo()( "window", 0 ) ) );
+   BOOST_REQUIRE_EQUAL( success(), transferid( N(alice), N(bob), 1, "not logged" ) );
+   BOOST_REQUIRE_EQUAL( 0, get_rows( N(eosio.nft).value, N(changes), "change" ).size() );
+   BOOST_REQUIRE_EQUAL( "8", get_rows( N(eosio.nft).value, N(changelog), "changelog" )[0]["next_seq"].as_string() );
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( query_tests, nft_tester ) try {
+
+   create( N(alice), string("NFT"));
+   produce_blocks(1);
+
+   push_action( N(alice), N(setbaseuri), mvo()
+        ( "sym", "NFT")
+        ( "base_uri", "https://cdn.example/nft/")
+   );
+
+   issue( N(alice), N(alice), asset::from_string("2 NFT"), {"a", "b"}, "nft1", "hola" );
+   issue( N(alice), N(alice), asset::from_string("5 NFT"), {}, "nft1", "range" );
+   BOOST_REQUIRE_EQUAL( success(), transferid( N(alice), N(bob), 4, "split" ) );
+
+   // Queries need no authority of the account they read
+   auto trace = push_action_trace( N(carol), N(ownerof), mvo()( "ids", vector<uint64_t>{0, 4, 99} ) );
+   BOOST_REQUIRE_EQUAL( "0 alice\n4 bob\n99 \n", trace->action_traces[0].console );
+
+   trace = push_action_trace( N(carol), N(tokensof), mvo()
+        ( "owner", "alice")
+        ( "sym", "")
+        ( "cursor", 0)
+        ( "limit", 3)
+   );
+   BOOST_REQUIRE_EQUAL( "token: 0 NFT https://cdn.example/nft/a\n"
+                        "token: 1 NFT https://cdn.example/nft/b\n"
+                        "range: 2 2 NFT https://cdn.example/nft/\n"
+                        "next id: 5", trace->action_traces[0].console );
+
+   trace = push_action_trace( N(carol), N(tokensof), mvo()
+        ( "owner", "alice")
+        ( "sym", "NFT")
+        ( "cursor", 5)
+        ( "limit", 3)
+   );
+   BOOST_REQUIRE_EQUAL( "range: 5 2 NFT https://cdn.example/nft/\n", trace->action_traces[0].console );
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "limit is too large" ),
+      push_action( N(carol), N(tokensof), mvo()
+        ( "owner", "alice")
+        ( "sym", "NFT")
+        ( "cursor", 0)
+        ( "limit", 101)
+      )
+   );
+
+   trace = push_action_trace( N(carol), N(supplyof), mvo()( "symbols", vector<string>{"NFT", "ART"} ) );
+   BOOST_REQUIRE_EQUAL( "7 NFT alice\n0 ART\n", trace->action_traces[0].console );
+
+} FC_LOG_AND_RETHROW()
+
 BOOST_FIXTURE_TEST_CASE( burn_tests, nft_tester ) try {
 
 	auto token = create( N(alice), string("NFT"));
@@ -469,4 +2299,194 @@ BOOST_FIXTURE_TEST_CASE( burn_tests, nft_tester ) try {
 
 } FC_LOG_AND_RETHROW()
 
+BOOST_FIXTURE_TEST_CASE( burnids_tests, nft_tester ) try {
+
+	create( N(alice), string("NFT"));
+	create( N(alice), string("ART"));
+	produce_blocks(1);
+
+	issue( N(alice), N(alice), asset::from_string("3 NFT"), {"uri1", "uri2", "uri3"}, "nft1", "issue 3 tokens" );
+	issue( N(alice), N(alice), asset::from_string("2 ART"), {"art1", "art2"}, "art1", "issue 2 tokens" );
+
+	BOOST_REQUIRE_EQUAL( success(), burnids( N(alice), {0, 3, 2} ) );
+
+	REQUIRE_MATCHING_OBJECT( get_stats("0,NFT"), mvo()
+		("supply", "1 NFT")
+		("issuer", "alice")
+	);
+	REQUIRE_MATCHING_OBJECT( get_stats("0,ART"), mvo()
+		("supply", "1 ART")
+		("issuer", "alice")
+	);
+	REQUIRE_MATCHING_OBJECT( get_account(N(alice), "0,NFT"), mvo()
+		("balance", "1 NFT")
+	);
+
+	BOOST_REQUIRE_EQUAL( wasm_assert_msg( "token with id does not exist" ),
+	   burnids( N(alice), {1, 0} )
+	);
+
+	BOOST_REQUIRE_EQUAL( wasm_assert_msg( "token with id does not exist" ),
+	   burnids( N(alice), {1, 1} )
+	);
+
+	BOOST_REQUIRE_EQUAL( wasm_assert_msg( "token not owned by account" ),
+	   burnids( N(bob), {1} )
+	);
+
+	BOOST_REQUIRE_EQUAL( wasm_assert_msg( "no token ids provided" ),
+	   burnids( N(alice), {} )
+	);
+
+	BOOST_REQUIRE_EQUAL( success(), burnids( N(alice), {1, 4} ) );
+	BOOST_REQUIRE_EQUAL( true, get_account(N(alice), "0,NFT").is_null() );
+	REQUIRE_MATCHING_OBJECT( get_stats("0,NFT"), mvo()
+		("supply", "0 NFT")
+		("issuer", "alice")
+	);
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( burnids_cpu_tests, nft_tester ) try {
+
+	const uint32_t count = 20;
+
+	create( N(alice), string("NFT"));
+	produce_blocks(1);
+
+	issue_n( N(alice), N(alice), "NFT", count * 4 );
+	produce_blocks(1);
+
+	// N single burns
+	uint32_t single_cpu = 0;
+	for( uint32_t i = 0; i < count; i++ )
+	{
+		auto trace = push_action_trace( N(alice), N(burn), mvo()
+		   ( "owner", "alice")
+		   ( "token_id", i)
+		);
+		single_cpu += trace->receipt->cpu_usage_us;
+	}
+	produce_blocks(1);
+
+	// One batch burn of the same size, the best of three
+	uint32_t batch_cpu = std::numeric_limits<uint32_t>::max();
+	for( uint32_t run = 1; run < 4; run++ )
+	{
+		vector<id_type> ids;
+		for( uint32_t i = count * run; i < count * ( run + 1 ); i++ )
+		{
+			ids.push_back( i );
+		}
+		auto trace = push_action_trace( N(alice), N(burnids), mvo()
+		   ( "owner", "alice")
+		   ( "ids", ids)
+		);
+		batch_cpu = std::min( batch_cpu, trace->receipt->cpu_usage_us );
+		produce_blocks(1);
+	}
+
+	// Billed CPU depends on the machine, so only the loose bound of one
+	// batch against the sum of the single burns is checked
+	BOOST_TEST_MESSAGE( count << " single burns: " << single_cpu << " us, burnids: " << batch_cpu << " us" );
+	BOOST_REQUIRE_LT( batch_cpu, single_cpu );
+
+	// Both ways leave the same state behind
+	REQUIRE_MATCHING_OBJECT( get_stats("0,NFT"), mvo()
+		("supply", "0 NFT")
+		("issuer", "alice")
+	);
+	BOOST_REQUIRE_EQUAL( 0, get_rows( N(alice), N(inventory), "holding" ).size() );
+	BOOST_REQUIRE_EQUAL( 0, get_rows( eosio::chain::symbol(0, "NFT").to_symbol_code().value, N(tokenmeta), "tokenmeta" ).size() );
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( variant_nobal_tests, nft_tester ) try {
+
+   use_variant( "nobal" );
+   create( N(alice), string("NFT"));
+   produce_blocks(1);
+
+   // Actions of the missing feature are not part of the build
+   BOOST_REQUIRE_EQUAL( "", abi_ser.get_action_type( N(setbalances) ) );
+   BOOST_REQUIRE_EQUAL( "beginissue", abi_ser.get_action_type( N(beginissue) ) );
+
+   issue( N(alice), N(alice), asset::from_string("3 NFT"), {"a", "b", "c"}, "nft1", "hola" );
+   BOOST_REQUIRE_EQUAL( success(), transferid( N(alice), N(bob), 1, "no balance" ) );
+   REQUIRE_MATCHING_OBJECT( get_token(1), mvo()
+      ("id", "1")
+      ("uri", "b")
+      ("owner", "bob")
+      ("sym", "NFT")
+   );
+   BOOST_REQUIRE_EQUAL( success(), transfer( N(alice), N(carol), asset::from_string("1 NFT"), "no balance" ) );
+   BOOST_REQUIRE_EQUAL( success(), burn( N(bob), 1 ) );
+
+   for( auto owner : { N(alice), N(bob), N(carol) } )
+      BOOST_REQUIRE_EQUAL( true, get_account(owner, "0,NFT").is_null() );
+   check_inventory( { "0,NFT" }, { N(alice), N(bob), N(carol) } );
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( variant_compact_tests, nft_tester ) try {
+
+   use_variant( "compact" );
+   create( N(alice), string("NFT"));
+   produce_blocks(1);
+
+   push_action( N(alice), N(setbaseuri), mvo()
+        ( "sym", "NFT")
+        ( "base_uri", "https://cdn.example/nft/")
+   );
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "this build issues tokens without uris" ),
+      issue( N(alice), N(alice), asset::from_string("1 NFT"), {"a"}, "nft1", "uri" )
+   );
+   BOOST_REQUIRE_EQUAL( "", abi_ser.get_action_type( N(beginissue) ) );
+   BOOST_REQUIRE_EQUAL( "", abi_ser.get_action_type( N(continueissue) ) );
+   BOOST_REQUIRE_EQUAL( "setbalances", abi_ser.get_action_type( N(setbalances) ) );
+
+   BOOST_REQUIRE_EQUAL( success(), issue( N(alice), N(alice), asset::from_string("5 NFT"), {}, "nft1", "range" ) );
+   BOOST_REQUIRE_EQUAL( success(), transferid( N(alice), N(bob), 2, "from the range" ) );
+   BOOST_REQUIRE_EQUAL( success(), burn( N(bob), 2 ) );
+
+   // Balances are kept, metadata rows never written
+   REQUIRE_MATCHING_OBJECT( get_account(N(alice), "0,NFT"), mvo()
+      ("balance", "4 NFT")
+   );
+   BOOST_REQUIRE_EQUAL( 0, get_rows( eosio::chain::symbol::from_string("0,NFT").to_symbol_code().value, N(tokenmeta), "tokenmeta" ).size() );
+   check_inventory( { "0,NFT" }, { N(alice), N(bob), N(carol) } );
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( variant_minimal_tests, nft_tester ) try {
+
+   use_variant( "minimal" );
+   create( N(alice), string("NFT"));
+   produce_blocks(1);
+
+   push_action( N(alice), N(setbaseuri), mvo()
+        ( "sym", "NFT")
+        ( "base_uri", "https://cdn.example/nft/")
+   );
+
+   for( auto act : { N(setbalances), N(beginissue), N(continueissue) } )
+      BOOST_REQUIRE_EQUAL( "", abi_ser.get_action_type( act ) );
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg( "this build issues tokens without uris" ),
+      issue( N(alice), N(alice), asset::from_string("1 NFT"), {"a"}, "nft1", "uri" )
+   );
+   BOOST_REQUIRE_EQUAL( success(), issue( N(alice), N(alice), asset::from_string("5 NFT"), {}, "nft1", "range" ) );
+   BOOST_REQUIRE_EQUAL( success(), transferids( N(alice), N(bob), {0, 3}, "from the range" ) );
+   BOOST_REQUIRE_EQUAL( success(), burnids( N(bob), {0, 3} ) );
+
+   BOOST_REQUIRE_EQUAL( true, get_account(N(alice), "0,NFT").is_null() );
+   REQUIRE_MATCHING_OBJECT( get_stats("0,NFT"), mvo()
+      ("supply", "3 NFT")
+      ("issuer", "alice")
+   );
+   check_inventory( { "0,NFT" }, { N(alice), N(bob), N(carol) } );
+
+} FC_LOG_AND_RETHROW()
+
 BOOST_AUTO_TEST_SUITE_END()
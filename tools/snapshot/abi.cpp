@@ -0,0 +1,352 @@
+#include "abi.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace nftsnap {
+
+   namespace {
+
+      // Minimal json document, enough for an ABI file
+      struct json {
+         enum kind_type { null_value, bool_value, number_value, string_value, array_value, object_value };
+
+         kind_type                                 kind = null_value;
+         std::string                               text;
+         std::vector<json>                         items;
+         std::vector<std::pair<std::string, json>> members;
+
+         const json* find( const std::string& key ) const {
+            for( const auto& m : members )
+               if( m.first == key ) return &m.second;
+            return nullptr;
+         }
+
+         const std::string& string_at( const std::string& key ) const {
+            static const std::string empty;
+            auto value = find( key );
+            return value && value->kind == string_value ? value->text : empty;
+         }
+
+         const std::vector<json>& array_at( const std::string& key ) const {
+            static const std::vector<json> empty;
+            auto value = find( key );
+            return value && value->kind == array_value ? value->items : empty;
+         }
+      };
+
+      class json_parser {
+         public:
+            explicit json_parser( const std::string& input ) : _pos(input.data()), _end(input.data() + input.size()) {}
+
+            json parse() {
+               json result = value();
+               skip_space();
+               if( _pos != _end ) fail( "trailing characters" );
+               return result;
+            }
+
+         private:
+            [[noreturn]] void fail( const char* what ) {
+               throw std::runtime_error( std::string( "invalid abi json: " ) + what );
+            }
+
+            void skip_space() {
+               while( _pos != _end && ( *_pos == ' ' || *_pos == '\t' || *_pos == '\n' || *_pos == '\r' ) ) ++_pos;
+            }
+
+            void expect( char c ) {
+               skip_space();
+               if( _pos == _end || *_pos != c ) fail( "unexpected character" );
+               ++_pos;
+            }
+
+            bool literal( const char* word ) {
+               auto n = strlen( word );
+               if( size_t(_end - _pos) < n || strncmp( _pos, word, n ) != 0 ) return false;
+               _pos += n;
+               return true;
+            }
+
+            std::string string_value() {
+               expect( '"' );
+               std::string result;
+               while( _pos != _end && *_pos != '"' ) {
+                  char c = *_pos++;
+                  if( c == '\\' ) {
+                     if( _pos == _end ) break;
+                     c = *_pos++;
+                     switch( c ) {
+                        case 'n': c = '\n'; break;
+                        case 't': c = '\t'; break;
+                        case 'r': c = '\r'; break;
+                        case 'b': c = '\b'; break;
+                        case 'f': c = '\f'; break;
+                        case 'u':
+                           // ABI names are ascii, keep the code point if it fits a byte
+                           if( _end - _pos < 4 ) fail( "bad escape" );
+                           c = char( std::stoi( std::string( _pos, 4 ), nullptr, 16 ) );
+                           _pos += 4;
+                           break;
+                        default: break;
+                     }
+                  }
+                  result.push_back( c );
+               }
+               if( _pos == _end ) fail( "unterminated string" );
+               ++_pos;
+               return result;
+            }
+
+            json value() {
+               skip_space();
+               if( _pos == _end ) fail( "unexpected end" );
+
+               json result;
+               if( *_pos == '{' ) {
+                  result.kind = json::object_value;
+                  ++_pos;
+                  skip_space();
+                  if( _pos != _end && *_pos == '}' ) { ++_pos; return result; }
+                  for( ;; ) {
+                     auto key = string_value();
+                     expect( ':' );
+                     result.members.emplace_back( key, value() );
+                     skip_space();
+                     if( _pos != _end && *_pos == ',' ) { ++_pos; continue; }
+                     expect( '}' );
+                     return result;
+                  }
+               }
+               if( *_pos == '[' ) {
+                  result.kind = json::array_value;
+                  ++_pos;
+                  skip_space();
+                  if( _pos != _end && *_pos == ']' ) { ++_pos; return result; }
+                  for( ;; ) {
+                     result.items.push_back( value() );
+                     skip_space();
+                     if( _pos != _end && *_pos == ',' ) { ++_pos; continue; }
+                     expect( ']' );
+                     return result;
+                  }
+               }
+               if( *_pos == '"' ) {
+                  result.kind = json::string_value;
+                  result.text = string_value();
+                  return result;
+               }
+               if( literal( "true" ) || literal( "false" ) ) {
+                  result.kind = json::bool_value;
+                  return result;
+               }
+               if( literal( "null" ) )
+                  return result;
+
+               auto start = _pos;
+               while( _pos != _end && strchr( "+-.eE0123456789", *_pos ) ) ++_pos;
+               if( start == _pos ) fail( "unexpected character" );
+               result.kind = json::number_value;
+               result.text.assign( start, _pos );
+               return result;
+            }
+
+            const char* _pos;
+            const char* _end;
+      };
+
+      template<typename T>
+      T read_int( const char*& pos, const char* end ) {
+         if( size_t(end - pos) < sizeof(T) ) throw std::runtime_error( "row data is too short" );
+         T value;
+         memcpy( &value, pos, sizeof(T) );
+         pos += sizeof(T);
+         return value;
+      }
+
+      uint32_t read_varuint32( const char*& pos, const char* end ) {
+         uint32_t value = 0;
+         for( int shift = 0; shift < 35; shift += 7 ) {
+            auto b = read_int<uint8_t>( pos, end );
+            value |= uint32_t( b & 0x7f ) << shift;
+            if( !( b & 0x80 ) ) return value;
+         }
+         throw std::runtime_error( "malformed varuint32" );
+      }
+
+   } // namespace
+
+   uint64_t string_to_name( std::string_view str ) {
+      if( str.size() > 13 ) throw std::runtime_error( "name is too long: " + std::string( str ) );
+
+      auto char_to_value = [&]( char c ) -> uint64_t {
+         if( c == '.' ) return 0;
+         if( c >= '1' && c <= '5' ) return ( c - '1' ) + 1;
+         if( c >= 'a' && c <= 'z' ) return ( c - 'a' ) + 6;
+         throw std::runtime_error( "invalid character in name: " + std::string( str ) );
+      };
+
+      uint64_t value = 0;
+      auto n = std::min( str.size(), size_t(12) );
+      for( size_t i = 0; i < n; ++i ) {
+         value <<= 5;
+         value |= char_to_value( str[i] );
+      }
+      value <<= ( 4 + 5 * ( 12 - n ) );
+      if( str.size() == 13 )
+         value |= char_to_value( str[12] ) & 0x0F;
+      return value;
+   }
+
+   std::string name_to_string( uint64_t value ) {
+      static const char* charmap = ".12345abcdefghijklmnopqrstuvwxyz";
+      std::string str( 13, '.' );
+      for( uint32_t i = 0; i <= 12; ++i ) {
+         str[12 - i] = charmap[ value & ( i == 0 ? 0x0f : 0x1f ) ];
+         value >>= ( i == 0 ? 4 : 5 );
+      }
+      auto last = str.find_last_not_of( '.' );
+      str.resize( last == std::string::npos ? 0 : last + 1 );
+      return str;
+   }
+
+   uint64_t string_to_symbol_code( std::string_view str ) {
+      if( str.empty() || str.size() > 7 ) throw std::runtime_error( "invalid symbol code: " + std::string( str ) );
+      uint64_t value = 0;
+      for( size_t i = 0; i < str.size(); ++i ) {
+         if( str[i] < 'A' || str[i] > 'Z' ) throw std::runtime_error( "invalid symbol code: " + std::string( str ) );
+         value |= uint64_t( str[i] ) << ( 8 * i );
+      }
+      return value;
+   }
+
+   std::string symbol_code_to_string( uint64_t value ) {
+      std::string str;
+      for( ; value; value >>= 8 )
+         str.push_back( char( value & 0xff ) );
+      return str;
+   }
+
+   abi::abi( const std::string& json_text ) {
+      auto doc = json_parser( json_text ).parse();
+      if( doc.kind != json::object_value ) throw std::runtime_error( "invalid abi json: not an object" );
+
+      for( const auto& t : doc.array_at( "types" ) )
+         _typedefs[ t.string_at( "new_type_name" ) ] = t.string_at( "type" );
+
+      for( const auto& s : doc.array_at( "structs" ) ) {
+         struct_def def;
+         def.base = s.string_at( "base" );
+         for( const auto& f : s.array_at( "fields" ) )
+            def.fields.push_back( { f.string_at( "name" ), f.string_at( "type" ) } );
+         _structs[ s.string_at( "name" ) ] = def;
+      }
+
+      for( const auto& t : doc.array_at( "tables" ) )
+         _tables[ t.string_at( "name" ) ] = t.string_at( "type" );
+   }
+
+   abi abi::from_file( const std::string& path ) {
+      std::ifstream in( path );
+      if( !in ) throw std::runtime_error( "cannot open " + path );
+      std::stringstream ss;
+      ss << in.rdbuf();
+      return abi( ss.str() );
+   }
+
+   const std::string& abi::table_type( const std::string& table ) const {
+      auto it = _tables.find( table );
+      if( it == _tables.end() ) throw std::runtime_error( "table is not in the abi: " + table );
+      return it->second;
+   }
+
+   row_fields abi::decode_row( const std::string& table, const char* data, size_t size ) const {
+      row_fields fields;
+      cursor c{ data, data + size };
+      decode_struct( table_type( table ), c, &fields );
+      if( c.pos != c.end ) throw std::runtime_error( "row of " + table + " has trailing data" );
+      return fields;
+   }
+
+   std::string abi::resolve( std::string type ) const {
+      for( auto it = _typedefs.find( type ); it != _typedefs.end(); it = _typedefs.find( type ) )
+         type = it->second;
+      return type;
+   }
+
+   void abi::decode_struct( const std::string& type, cursor& c, row_fields* out ) const {
+      auto it = _structs.find( type );
+      if( it == _structs.end() ) throw std::runtime_error( "unknown abi type: " + type );
+
+      if( !it->second.base.empty() )
+         decode_struct( resolve( it->second.base ), c, out );
+
+      for( const auto& f : it->second.fields ) {
+         // Only top level fields are kept, nested structs are skipped over
+         decode( f.type, c, out ? &(*out)[ f.name ] : nullptr );
+      }
+   }
+
+   void abi::decode( const std::string& raw_type, cursor& c, field_value* out ) const {
+      field_value ignored;
+      field_value& v = out ? *out : ignored;
+      auto type = resolve( raw_type );
+
+      if( type.size() > 2 && type.compare( type.size() - 2, 2, "[]" ) == 0 ) {
+         auto count = read_varuint32( c.pos, c.end );
+         auto item = type.substr( 0, type.size() - 2 );
+         for( uint32_t i = 0; i < count; ++i )
+            decode( item, c, nullptr );
+         v.number = count;
+         return;
+      }
+      if( !type.empty() && type.back() == '?' ) {
+         if( read_int<uint8_t>( c.pos, c.end ) )
+            decode( type.substr( 0, type.size() - 1 ), c, out );
+         return;
+      }
+
+      if( type == "bool" || type == "uint8" )   { v.number = read_int<uint8_t>( c.pos, c.end ); return; }
+      if( type == "int8" )                      { v.amount = read_int<int8_t>( c.pos, c.end ); return; }
+      if( type == "uint16" )                    { v.number = read_int<uint16_t>( c.pos, c.end ); return; }
+      if( type == "int16" )                     { v.amount = read_int<int16_t>( c.pos, c.end ); return; }
+      if( type == "uint32" )                    { v.number = read_int<uint32_t>( c.pos, c.end ); return; }
+      if( type == "int32" )                     { v.amount = read_int<int32_t>( c.pos, c.end ); return; }
+      if( type == "int64" )                     { v.amount = read_int<int64_t>( c.pos, c.end ); return; }
+      if( type == "varuint32" )                 { v.number = read_varuint32( c.pos, c.end ); return; }
+
+      if( type == "uint64" || type == "name" || type == "symbol_code" ) {
+         v.number = read_int<uint64_t>( c.pos, c.end );
+         return;
+      }
+      if( type == "symbol" ) {
+         // Precision in the low byte, the code above it
+         v.number = read_int<uint64_t>( c.pos, c.end ) >> 8;
+         return;
+      }
+      if( type == "asset" ) {
+         v.amount = read_int<int64_t>( c.pos, c.end );
+         v.number = read_int<uint64_t>( c.pos, c.end ) >> 8;
+         return;
+      }
+      if( type == "string" || type == "bytes" ) {
+         auto size = read_varuint32( c.pos, c.end );
+         if( size_t(c.end - c.pos) < size ) throw std::runtime_error( "row data is too short" );
+         v.text.assign( c.pos, size );
+         c.pos += size;
+         return;
+      }
+      if( type == "checksum256" ) {
+         if( c.end - c.pos < 32 ) throw std::runtime_error( "row data is too short" );
+         v.text.assign( c.pos, 32 );
+         c.pos += 32;
+         return;
+      }
+
+      decode_struct( type, c, nullptr );
+   }
+
+} // namespace nftsnap
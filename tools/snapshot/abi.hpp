@@ -0,0 +1,73 @@
+/**
+ *  Just enough of an ABI to decode eosio.nft table rows off the chain.
+ *
+ *  Reads the struct, typedef and table definitions of eosio.nft.abi and
+ *  decodes the binary layout of a row into its top level fields.  Only the
+ *  built-in types used by the contract tables are supported.
+ */
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace nftsnap {
+
+   uint64_t string_to_name( std::string_view str );
+   std::string name_to_string( uint64_t value );
+
+   uint64_t string_to_symbol_code( std::string_view str );
+   std::string symbol_code_to_string( uint64_t value );
+
+   /// A decoded field: numbers, names and symbols are kept in "number",
+   /// an asset keeps its amount in "amount" and its symbol code in "number".
+   struct field_value {
+      uint64_t    number = 0;
+      int64_t     amount = 0;
+      std::string text;
+   };
+
+   typedef std::map<std::string, field_value> row_fields;
+
+   class abi {
+      public:
+         /// Parses the ABI json, throws std::runtime_error on malformed input.
+         explicit abi( const std::string& json );
+
+         static abi from_file( const std::string& path );
+
+         /// Row type stored in "table", e.g. "token" for "tokens".
+         const std::string& table_type( const std::string& table ) const;
+
+         /// Decodes a row of "table", throws std::runtime_error when the
+         /// data does not match the row type.
+         row_fields decode_row( const std::string& table, const char* data, size_t size ) const;
+
+      private:
+         struct field {
+            std::string name;
+            std::string type;
+         };
+
+         struct struct_def {
+            std::string        base;
+            std::vector<field> fields;
+         };
+
+         struct cursor {
+            const char* pos;
+            const char* end;
+         };
+
+         std::string resolve( std::string type ) const;
+         void decode( const std::string& type, cursor& c, field_value* out ) const;
+         void decode_struct( const std::string& type, cursor& c, row_fields* out ) const;
+
+         std::map<std::string, std::string> _typedefs;
+         std::map<std::string, struct_def>  _structs;
+         std::map<std::string, std::string> _tables;
+   };
+
+} // namespace nftsnap
@@ -0,0 +1,113 @@
+/**
+ *  Builds and queries eosio.nft snapshots.
+ *
+ *     nft_snapshot build <abi> <row dump> <snapshot>
+ *     nft_snapshot owner <snapshot> <account>     tokens of an account
+ *     nft_snapshot symbol <snapshot> <code>       tokens of a symbol
+ *     nft_snapshot supply <snapshot>              supply per symbol
+ *     nft_snapshot balance <snapshot> <account>   balances of an account
+ *
+ *  Query results go to stdout, the time spent on the query to stderr.
+ */
+#include "snapshot.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+using namespace nftsnap;
+
+namespace {
+
+   typedef std::chrono::steady_clock clock_type;
+
+   void report( const char* what, uint64_t count, clock_type::time_point started ) {
+      std::chrono::duration<double, std::milli> elapsed = clock_type::now() - started;
+      std::fprintf( stderr, "%llu %s in %.3f ms\n", (unsigned long long)count, what, elapsed.count() );
+   }
+
+   // One line per token, a range prints its first id, its count and the uri of its first token
+   void print_token( const snapshot& snap, uint64_t row ) {
+      if( snap.count( row ) > 1 )
+         std::printf( "range %llu %llu ", (unsigned long long)snap.id( row ), (unsigned long long)snap.count( row ) );
+      else
+         std::printf( "%llu ", (unsigned long long)snap.id( row ) );
+      std::printf( "%s %s %s\n", name_to_string( snap.owner( row ) ).c_str(),
+                   symbol_code_to_string( snap.symbol( row ) ).c_str(),
+                   snap.uri( row ).c_str() );
+   }
+
+   int usage( const char* self ) {
+      std::fprintf( stderr,
+         "usage: %s build <abi> <row dump> <snapshot>\n"
+         "       %s owner <snapshot> <account>\n"
+         "       %s symbol <snapshot> <code>\n"
+         "       %s supply <snapshot>\n"
+         "       %s balance <snapshot> <account>\n", self, self, self, self, self );
+      return 1;
+   }
+
+}
+
+int main( int argc, char** argv ) try {
+   if( argc < 3 ) return usage( argv[0] );
+   std::string command = argv[1];
+
+   if( command == "build" && argc == 5 ) {
+      auto started = clock_type::now();
+      auto stats = build_snapshot( abi::from_file( argv[2] ), argv[3], argv[4] );
+      std::printf( "%llu tokens in %llu rows, %llu owners, %llu symbols, %llu balances\n",
+                   (unsigned long long)stats.tokens, (unsigned long long)stats.rows, (unsigned long long)stats.holders,
+                   (unsigned long long)stats.symbols, (unsigned long long)stats.accounts );
+      report( "rows written", stats.rows, started );
+      return 0;
+   }
+
+   if( command == "owner" && argc == 4 ) {
+      snapshot snap( argv[2] );
+      auto started = clock_type::now();
+      auto rows = snap.tokens_of( string_to_name( argv[3] ) );
+      report( "rows found", rows.count, started );
+      for( uint64_t row = rows.first; row < rows.first + rows.count; ++row )
+         print_token( snap, row );
+      return 0;
+   }
+
+   if( command == "symbol" && argc == 4 ) {
+      snapshot snap( argv[2] );
+      auto started = clock_type::now();
+      auto rows = snap.rows_of_symbol( string_to_symbol_code( argv[3] ) );
+      report( "rows found", rows.size(), started );
+      for( auto row : rows )
+         print_token( snap, row );
+      return 0;
+   }
+
+   if( command == "supply" && argc == 3 ) {
+      snapshot snap( argv[2] );
+      auto started = clock_type::now();
+      auto symbols = snap.symbols();
+      report( "symbols found", symbols.size(), started );
+      // Supply of the stat table next to the number of tokens actually held
+      for( const auto& s : symbols )
+         std::printf( "%s supply %lld tokens %llu issuer %s\n", symbol_code_to_string( s.sym ).c_str(),
+                      (long long)s.supply, (unsigned long long)s.tokens, name_to_string( s.issuer ).c_str() );
+      return 0;
+   }
+
+   if( command == "balance" && argc == 4 ) {
+      snapshot snap( argv[2] );
+      auto started = clock_type::now();
+      auto balances = snap.accounts_of( string_to_name( argv[3] ) );
+      report( "balances found", balances.size(), started );
+      for( const auto& a : balances )
+         std::printf( "%lld %s\n", (long long)a.amount, symbol_code_to_string( a.sym ).c_str() );
+      return 0;
+   }
+
+   return usage( argv[0] );
+} catch( const std::exception& e ) {
+   std::fprintf( stderr, "error: %s\n", e.what() );
+   return 1;
+}
@@ -0,0 +1,407 @@
+#include "snapshot.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace nftsnap {
+
+   namespace {
+
+      struct token_row {
+         uint64_t id;
+         uint64_t count;
+         uint64_t owner;
+         uint64_t sym;
+         uint64_t uri_offset;
+         uint64_t uri_size;
+         uint8_t  uri_flags;
+      };
+
+      struct meta_row {
+         uint64_t uri_offset;
+         uint64_t uri_size;
+         uint8_t  uri_flags;
+      };
+
+      struct symbol_info {
+         int64_t     supply = 0;
+         uint64_t    issuer = 0;
+         std::string base_uri;
+         bool        no_balances = false;
+      };
+
+      uint64_t align8( uint64_t offset ) {
+         return ( offset + 7 ) & ~uint64_t(7);
+      }
+
+      class section_writer {
+         public:
+            explicit section_writer( const std::string& path ) : _out( path, std::ios::binary | std::ios::trunc ) {
+               if( !_out ) throw std::runtime_error( "cannot create " + path );
+            }
+
+            uint64_t offset() const { return _offset; }
+
+            void write( const void* data, size_t size ) {
+               _out.write( static_cast<const char*>( data ), size );
+               _offset += size;
+            }
+
+            template<typename T>
+            uint64_t write_section( const std::vector<T>& items ) {
+               pad();
+               auto start = _offset;
+               if( !items.empty() )
+                  write( items.data(), items.size() * sizeof(T) );
+               return start;
+            }
+
+            void pad() {
+               static const char zeros[8] = {};
+               write( zeros, align8( _offset ) - _offset );
+            }
+
+            void seek_start() { _out.seekp( 0 ); }
+
+            void close() {
+               _out.close();
+               if( !_out ) throw std::runtime_error( "cannot write snapshot" );
+            }
+
+         private:
+            std::ofstream _out;
+            uint64_t      _offset = 0;
+      };
+
+   } // namespace
+
+   void for_each_row( const std::string& path,
+                      const std::function<void(uint64_t, uint64_t, uint64_t, const char*, size_t)>& fn ) {
+      std::ifstream in( path, std::ios::binary );
+      if( !in ) throw std::runtime_error( "cannot open " + path );
+
+      char magic[8];
+      if( !in.read( magic, sizeof(magic) ) || memcmp( magic, row_dump_magic, sizeof(magic) ) != 0 )
+         throw std::runtime_error( path + " is not a row dump" );
+
+      std::vector<char> data;
+      for( ;; ) {
+         uint64_t keys[3];
+         uint32_t size;
+         if( !in.read( reinterpret_cast<char*>( keys ), sizeof(keys) ) ) {
+            if( in.gcount() == 0 ) break;
+            throw std::runtime_error( path + " ends inside a record" );
+         }
+         if( !in.read( reinterpret_cast<char*>( &size ), sizeof(size) ) )
+            throw std::runtime_error( path + " ends inside a record" );
+         data.resize( size );
+         if( size && !in.read( data.data(), size ) )
+            throw std::runtime_error( path + " ends inside a record" );
+
+         fn( keys[0], keys[1], keys[2], data.data(), size );
+      }
+   }
+
+   build_stats build_snapshot( const abi& contract_abi, const std::string& dump_path, const std::string& out_path ) {
+      const uint64_t tokens_table     = string_to_name( "tokens" );
+      const uint64_t tokenmeta_table  = string_to_name( "tokenmeta" );
+      const uint64_t ranges_table     = string_to_name( "ranges" );
+      const uint64_t hashtokens_table = string_to_name( "hashtokens" );
+      const uint64_t accounts_table   = string_to_name( "accounts" );
+      const uint64_t stat_table       = string_to_name( "stat" );
+      const uint64_t collection_table = string_to_name( "collection" );
+
+      std::vector<token_row>          tokens;
+      std::vector<char>               blob;
+      std::vector<account_entry>      accounts;
+      std::map<uint64_t, symbol_info> symbols;
+      std::unordered_map<uint64_t, meta_row> metas;
+
+      for_each_row( dump_path, [&]( uint64_t scope, uint64_t table, uint64_t, const char* data, size_t size ) {
+         if( table == tokens_table ) {
+            auto row = contract_abi.decode_row( "tokens", data, size );
+            tokens.push_back( { row["id"].number, 1, row["owner"].number, row["sym"].number, 0, 0, 0 } );
+         } else if( table == tokenmeta_table ) {
+            // Uri suffixes live on metadata rows, joined to the tokens by id below
+            auto row = contract_abi.decode_row( "tokenmeta", data, size );
+            const auto& uri = row["uri"].text;
+            uint8_t flags = row["absolute"].number ? uri_absolute : 0;
+            metas[ row["id"].number ] = { blob.size(), uri.size(), flags };
+            blob.insert( blob.end(), uri.begin(), uri.end() );
+         } else if( table == ranges_table ) {
+            // One row for the whole range, the uris are derived from the ids
+            auto row = contract_abi.decode_row( "ranges", data, size );
+            tokens.push_back( { row["start"].number, row["count"].number, row["owner"].number, row["sym"].number, 0, 0, 0 } );
+         } else if( table == hashtokens_table ) {
+            // The hex hash is kept as the suffix, its uri is built with the base uri
+            static const char* digits = "0123456789abcdef";
+            auto row = contract_abi.decode_row( "hashtokens", data, size );
+            tokens.push_back( { row["id"].number, 1, row["owner"].number, row["sym"].number, blob.size(), 0, uri_hash } );
+            for( unsigned char b : row["content_hash"].text ) {
+               blob.push_back( digits[b >> 4] );
+               blob.push_back( digits[b & 0x0f] );
+            }
+            tokens.back().uri_size = blob.size() - tokens.back().uri_offset;
+         } else if( table == accounts_table ) {
+            auto row = contract_abi.decode_row( "accounts", data, size );
+            accounts.push_back( { scope, row["balance"].number, row["balance"].amount } );
+         } else if( table == stat_table ) {
+            auto row = contract_abi.decode_row( "stat", data, size );
+            auto& info = symbols[ row["supply"].number ];
+            info.supply = row["supply"].amount;
+            info.issuer = row["issuer"].number;
+         } else if( table == collection_table ) {
+            auto row = contract_abi.decode_row( "collection", data, size );
+            auto& info = symbols[ row["sym"].number ];
+            info.base_uri = row["base_uri"].text;
+            info.no_balances = row["no_balances"].number != 0;
+         }
+      });
+
+      for( auto& t : tokens ) {
+         auto meta = metas.find( t.id );
+         if( meta != metas.end() ) {
+            t.uri_offset = meta->second.uri_offset;
+            t.uri_size = meta->second.uri_size;
+            t.uri_flags = meta->second.uri_flags;
+         }
+      }
+      decltype( metas )().swap( metas );
+
+      std::sort( tokens.begin(), tokens.end(), []( const token_row& a, const token_row& b ) {
+         return std::tie( a.owner, a.id ) < std::tie( b.owner, b.id );
+      });
+
+      // Symbols without balance rows get them counted from the tokens
+      std::map<std::pair<uint64_t, uint64_t>, int64_t> counted;
+      for( const auto& t : tokens ) {
+         auto info = symbols.find( t.sym );
+         if( info != symbols.end() && info->second.no_balances )
+            counted[{ t.owner, t.sym }] += t.count;
+      }
+      for( const auto& c : counted )
+         accounts.push_back( { c.first.first, c.first.second, c.second } );
+
+      std::sort( accounts.begin(), accounts.end(), []( const account_entry& a, const account_entry& b ) {
+         return std::tie( a.owner, a.sym ) < std::tie( b.owner, b.sym );
+      });
+
+      // Columns, in owner order
+      std::vector<uint64_t> ids( tokens.size() ), counts( tokens.size() ), owners( tokens.size() ), syms( tokens.size() );
+      std::vector<uint64_t> uri_offsets( tokens.size() + 1 );
+      std::vector<uint8_t>  uri_flags( tokens.size() );
+      std::vector<char>     uri_blob;
+      uri_blob.reserve( blob.size() );
+      for( size_t i = 0; i < tokens.size(); ++i ) {
+         const auto& t = tokens[i];
+         ids[i] = t.id;
+         counts[i] = t.count;
+         owners[i] = t.owner;
+         syms[i] = t.sym;
+         uri_offsets[i] = uri_blob.size();
+         uri_flags[i] = t.uri_flags;
+         uri_blob.insert( uri_blob.end(), blob.begin() + t.uri_offset, blob.begin() + t.uri_offset + t.uri_size );
+         symbols[ t.sym ];
+      }
+      uri_offsets[ tokens.size() ] = uri_blob.size();
+      std::vector<char>().swap( blob );
+
+      std::vector<holder_entry> holders;
+      for( uint64_t row = 0; row < tokens.size(); ++row ) {
+         if( holders.empty() || holders.back().owner != owners[row] )
+            holders.push_back( { owners[row], row, 0, 0 } );
+         holders.back().count++;
+         holders.back().tokens += counts[row];
+      }
+
+      // Symbol index, rows ordered by symbol and id
+      std::vector<uint64_t> by_symbol( tokens.size() );
+      for( uint64_t row = 0; row < tokens.size(); ++row )
+         by_symbol[row] = row;
+      std::sort( by_symbol.begin(), by_symbol.end(), [&]( uint64_t a, uint64_t b ) {
+         return std::tie( syms[a], ids[a] ) < std::tie( syms[b], ids[b] );
+      });
+      tokens.clear();
+      tokens.shrink_to_fit();
+
+      std::vector<symbol_entry> symbol_dir;
+      uint64_t next = 0;
+      for( const auto& s : symbols ) {
+         symbol_entry entry{ s.first, next, 0, 0, s.second.supply, s.second.issuer, uri_blob.size(), s.second.base_uri.size() };
+         while( next < by_symbol.size() && syms[ by_symbol[next] ] == s.first ) {
+            entry.tokens += counts[ by_symbol[next] ];
+            ++next;
+            ++entry.count;
+         }
+         uri_blob.insert( uri_blob.end(), s.second.base_uri.begin(), s.second.base_uri.end() );
+         symbol_dir.push_back( entry );
+      }
+
+      file_header header{};
+      memcpy( header.magic, snapshot_magic, sizeof(header.magic) );
+      header.row_count = ids.size();
+      for( auto c : counts )
+         header.token_count += c;
+      header.holder_count = holders.size();
+      header.symbol_count = symbol_dir.size();
+      header.account_count = accounts.size();
+      header.blob_size = uri_blob.size();
+
+      section_writer out( out_path );
+      out.write( &header, sizeof(header) );
+      header.ids = out.write_section( ids );
+      header.counts = out.write_section( counts );
+      header.owners = out.write_section( owners );
+      header.symbols = out.write_section( syms );
+      header.uri_offsets = out.write_section( uri_offsets );
+      header.uri_flags = out.write_section( uri_flags );
+      header.by_symbol = out.write_section( by_symbol );
+      header.holders = out.write_section( holders );
+      header.symbol_dir = out.write_section( symbol_dir );
+      header.accounts = out.write_section( accounts );
+      header.blob = out.write_section( uri_blob );
+      out.pad();
+
+      // Header again, now with the section offsets
+      out.seek_start();
+      out.write( &header, sizeof(header) );
+      out.close();
+
+      build_stats stats;
+      stats.rows = header.row_count;
+      stats.tokens = header.token_count;
+      stats.holders = header.holder_count;
+      stats.symbols = header.symbol_count;
+      stats.accounts = header.account_count;
+      return stats;
+   }
+
+   snapshot::snapshot( const std::string& path ) {
+      int fd = ::open( path.c_str(), O_RDONLY );
+      if( fd < 0 ) throw std::runtime_error( "cannot open " + path );
+
+      struct stat st;
+      if( ::fstat( fd, &st ) != 0 || size_t(st.st_size) < sizeof(file_header) ) {
+         ::close( fd );
+         throw std::runtime_error( path + " is not a snapshot" );
+      }
+
+      _size = st.st_size;
+      void* mapped = ::mmap( nullptr, _size, PROT_READ, MAP_SHARED, fd, 0 );
+      ::close( fd );
+      if( mapped == MAP_FAILED ) throw std::runtime_error( "cannot map " + path );
+      _data = static_cast<const char*>( mapped );
+
+      _header = reinterpret_cast<const file_header*>( _data );
+      if( memcmp( _header->magic, snapshot_magic, sizeof(snapshot_magic) ) != 0 ) {
+         ::munmap( mapped, _size );
+         throw std::runtime_error( path + " is not a snapshot" );
+      }
+
+      // Every section must lie inside the file
+      auto section = [&]( uint64_t offset, uint64_t count, size_t item ) {
+         if( offset % 8 || offset > _size || count > ( _size - offset ) / item ) {
+            ::munmap( mapped, _size );
+            throw std::runtime_error( path + " is truncated or corrupt" );
+         }
+         return _data + offset;
+      };
+      const auto& h = *_header;
+      _ids         = reinterpret_cast<const uint64_t*>( section( h.ids, h.row_count, 8 ) );
+      _counts      = reinterpret_cast<const uint64_t*>( section( h.counts, h.row_count, 8 ) );
+      _owners      = reinterpret_cast<const uint64_t*>( section( h.owners, h.row_count, 8 ) );
+      _symbols     = reinterpret_cast<const uint64_t*>( section( h.symbols, h.row_count, 8 ) );
+      _uri_offsets = reinterpret_cast<const uint64_t*>( section( h.uri_offsets, h.row_count + 1, 8 ) );
+      _uri_flags   = reinterpret_cast<const uint8_t*>( section( h.uri_flags, h.row_count, 1 ) );
+      _by_symbol   = reinterpret_cast<const uint64_t*>( section( h.by_symbol, h.row_count, 8 ) );
+      _holders     = reinterpret_cast<const holder_entry*>( section( h.holders, h.holder_count, sizeof(holder_entry) ) );
+      _symbol_dir  = reinterpret_cast<const symbol_entry*>( section( h.symbol_dir, h.symbol_count, sizeof(symbol_entry) ) );
+      _accounts    = reinterpret_cast<const account_entry*>( section( h.accounts, h.account_count, sizeof(account_entry) ) );
+      _blob        = section( h.blob, h.blob_size, 1 );
+   }
+
+   snapshot::~snapshot() {
+      ::munmap( const_cast<char*>( _data ), _size );
+   }
+
+   std::string_view snapshot::uri_suffix( uint64_t row ) const {
+      auto begin = _uri_offsets[row];
+      auto end = _uri_offsets[row + 1];
+      return std::string_view( _blob + begin, end - begin );
+   }
+
+   std::string snapshot::uri( uint64_t row, uint64_t index ) const {
+      auto suffix = uri_suffix( row );
+      if( _uri_flags[row] & uri_absolute )
+         return std::string( suffix );
+
+      auto sym = find_symbol( symbol( row ) );
+      std::string base = sym ? std::string( _blob + sym->base_uri_offset, sym->base_uri_size ) : std::string();
+
+      if( _uri_flags[row] & uri_hash ) {
+         auto pos = base.find( "{hash}" );
+         return pos == std::string::npos ? base + std::string( suffix ) : base.replace( pos, 6, suffix );
+      }
+
+      if( suffix.empty() )
+         return base.empty() ? std::string() : base + std::to_string( id( row ) + index );
+      return base + std::string( suffix );
+   }
+
+   snapshot::row_range snapshot::tokens_of( uint64_t owner ) const {
+      auto all = holders();
+      auto it = std::lower_bound( all.begin(), all.end(), owner, []( const holder_entry& h, uint64_t o ) {
+         return h.owner < o;
+      });
+      if( it == all.end() || it->owner != owner )
+         return {};
+      return { it->first, it->count };
+   }
+
+   slice<uint64_t> snapshot::rows_of_symbol( uint64_t sym ) const {
+      auto entry = find_symbol( sym );
+      if( !entry )
+         return {};
+      return { _by_symbol + entry->first, _by_symbol + entry->first + entry->count };
+   }
+
+   const symbol_entry* snapshot::find_symbol( uint64_t sym ) const {
+      auto all = symbols();
+      auto it = std::lower_bound( all.begin(), all.end(), sym, []( const symbol_entry& s, uint64_t code ) {
+         return s.sym < code;
+      });
+      return it != all.end() && it->sym == sym ? it : nullptr;
+   }
+
+   slice<account_entry> snapshot::accounts_of( uint64_t owner ) const {
+      auto all = accounts();
+      auto first = std::lower_bound( all.begin(), all.end(), owner, []( const account_entry& a, uint64_t o ) {
+         return a.owner < o;
+      });
+      auto last = std::upper_bound( first, all.end(), owner, []( uint64_t o, const account_entry& a ) {
+         return o < a.owner;
+      });
+      return { first, last };
+   }
+
+   int64_t snapshot::balance( uint64_t owner, uint64_t sym ) const {
+      auto all = accounts();
+      auto it = std::lower_bound( all.begin(), all.end(), std::make_pair( owner, sym ),
+                                  []( const account_entry& a, const std::pair<uint64_t, uint64_t>& key ) {
+         return std::tie( a.owner, a.sym ) < std::tie( key.first, key.second );
+      });
+      return it != all.end() && it->owner == owner && it->sym == sym ? it->amount : 0;
+   }
+
+} // namespace nftsnap
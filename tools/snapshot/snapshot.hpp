@@ -0,0 +1,182 @@
+/**
+ *  Columnar, memory-mappable snapshot of the eosio.nft token, accounts and
+ *  stat tables.
+ *
+ *  Input is a row dump: the 8 bytes "NFTROWS1" followed by one record per
+ *  table row,
+ *
+ *     uint64 scope, uint64 table, uint64 primary key, uint32 size, size bytes
+ *
+ *  with the row bytes exactly as stored on chain.  The eosio.nft benchmarks
+ *  write one with NFT_BENCH_DUMP.
+ *
+ *  Output is a single little-endian file of fixed layout sections, each 8 byte
+ *  aligned, that the reader maps without parsing.  A range of tokens issued
+ *  without uris stays one row with its token count, so a snapshot is as
+ *  large as the tables.  Content-addressed tokens keep their hex hash as uri
+ *  suffix.  Rows are sorted by owner and id, so the tokens of an account are
+ *  one contiguous run of rows.
+ */
+#pragma once
+
+#include "abi.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace nftsnap {
+
+   constexpr char row_dump_magic[8] = { 'N','F','T','R','O','W','S','1' };
+   constexpr char snapshot_magic[8] = { 'N','F','T','S','N','A','P','3' };
+
+   /// Calls "fn" for every record of a row dump, throws std::runtime_error on a malformed dump.
+   void for_each_row( const std::string& path,
+                      const std::function<void(uint64_t scope, uint64_t table, uint64_t primary_key,
+                                               const char* data, size_t size)>& fn );
+
+   struct file_header {
+      char     magic[8];
+      uint64_t row_count;
+      uint64_t token_count;   // sum of the row counts
+      uint64_t holder_count;
+      uint64_t symbol_count;
+      uint64_t account_count;
+      uint64_t blob_size;
+
+      // Section offsets from the start of the file
+      uint64_t ids;           // uint64[row_count], token id, the first id of a range
+      uint64_t counts;        // uint64[row_count], 1 for a token, the size of a range
+      uint64_t owners;        // uint64[row_count], owner name
+      uint64_t symbols;       // uint64[row_count], symbol code
+      uint64_t uri_offsets;   // uint64[row_count + 1], uri suffix i is blob[off[i], off[i+1])
+      uint64_t uri_flags;     // uint8[row_count], uri_absolute or uri_hash
+      uint64_t by_symbol;     // uint64[row_count], rows sorted by symbol and id
+      uint64_t holders;       // holder_entry[holder_count], sorted by owner
+      uint64_t symbol_dir;    // symbol_entry[symbol_count], sorted by symbol code
+      uint64_t accounts;      // account_entry[account_count], sorted by owner and symbol
+      uint64_t blob;          // char[blob_size], uri suffixes and base uris
+   };
+
+   /// Token uri stored whole, the collection base uri is not prepended.
+   constexpr uint8_t uri_absolute = 1;
+   /// Content-addressed token, the suffix is the hex hash that replaces
+   /// "{hash}" in the base uri or follows it.
+   constexpr uint8_t uri_hash = 2;
+
+   /// Rows [first, first + count) hold the "tokens" tokens of "owner".
+   struct holder_entry {
+      uint64_t owner;
+      uint64_t first;
+      uint64_t count;
+      uint64_t tokens;
+   };
+
+   /// by_symbol[first, first + count) are the rows of the "tokens" tokens of "sym".
+   struct symbol_entry {
+      uint64_t sym;
+      uint64_t first;
+      uint64_t count;
+      uint64_t tokens;
+      int64_t  supply;            // from the stat table
+      uint64_t issuer;
+      uint64_t base_uri_offset;   // collection base uri in the blob
+      uint64_t base_uri_size;
+   };
+
+   struct account_entry {
+      uint64_t owner;
+      uint64_t sym;
+      int64_t  amount;
+   };
+
+   struct build_stats {
+      uint64_t rows = 0;
+      uint64_t tokens = 0;
+      uint64_t holders = 0;
+      uint64_t symbols = 0;
+      uint64_t accounts = 0;
+   };
+
+   /// Decodes the rows of a dump with "contract_abi" and writes the snapshot to "out_path".
+   build_stats build_snapshot( const abi& contract_abi, const std::string& dump_path, const std::string& out_path );
+
+   template<typename T>
+   struct slice {
+      const T* first = nullptr;
+      const T* last = nullptr;
+
+      const T* begin() const { return first; }
+      const T* end() const { return last; }
+      size_t size() const { return last - first; }
+      bool empty() const { return first == last; }
+   };
+
+   /// Read-only view of a snapshot file mapped into memory.
+   class snapshot {
+      public:
+         /// Maps "path", throws std::runtime_error when it is not a valid snapshot.
+         explicit snapshot( const std::string& path );
+         ~snapshot();
+
+         snapshot( const snapshot& ) = delete;
+         snapshot& operator=( const snapshot& ) = delete;
+
+         uint64_t size() const { return _header->row_count; }
+         uint64_t token_count() const { return _header->token_count; }
+
+         uint64_t id( uint64_t row ) const { return _ids[row]; }
+         uint64_t count( uint64_t row ) const { return _counts[row]; }
+         uint64_t owner( uint64_t row ) const { return _owners[row]; }
+         uint64_t symbol( uint64_t row ) const { return _symbols[row]; }
+         std::string_view uri_suffix( uint64_t row ) const;
+
+         /// Full uri like token::get_uri of token "index" of the row, the
+         /// collection base uri followed by the suffix, the suffix alone when
+         /// it is absolute, or the base uri followed by the id when the token
+         /// has no suffix. Content-addressed tokens follow hashtoken::get_uri.
+         std::string uri( uint64_t row, uint64_t index = 0 ) const;
+
+         struct row_range {
+            uint64_t first = 0;
+            uint64_t count = 0;
+         };
+
+         /// Rows of every token and range owned by "owner", empty when it has none.
+         row_range tokens_of( uint64_t owner ) const;
+
+         /// Rows of every token and range with symbol code "sym".
+         slice<uint64_t> rows_of_symbol( uint64_t sym ) const;
+
+         slice<holder_entry> holders() const { return { _holders, _holders + _header->holder_count }; }
+         slice<symbol_entry> symbols() const { return { _symbol_dir, _symbol_dir + _header->symbol_count }; }
+         slice<account_entry> accounts() const { return { _accounts, _accounts + _header->account_count }; }
+
+         /// Symbol directory entry of "sym", nullptr when unknown.
+         const symbol_entry* find_symbol( uint64_t sym ) const;
+
+         /// Balance rows of "owner", one per symbol.
+         slice<account_entry> accounts_of( uint64_t owner ) const;
+
+         /// Balance of "owner" in "sym", 0 when it has no balance row.
+         int64_t balance( uint64_t owner, uint64_t sym ) const;
+
+      private:
+         const char*          _data = nullptr;
+         size_t               _size = 0;
+         const file_header*   _header = nullptr;
+         const uint64_t*      _ids = nullptr;
+         const uint64_t*      _counts = nullptr;
+         const uint64_t*      _owners = nullptr;
+         const uint64_t*      _symbols = nullptr;
+         const uint64_t*      _uri_offsets = nullptr;
+         const uint8_t*       _uri_flags = nullptr;
+         const uint64_t*      _by_symbol = nullptr;
+         const holder_entry*  _holders = nullptr;
+         const symbol_entry*  _symbol_dir = nullptr;
+         const account_entry* _accounts = nullptr;
+         const char*          _blob = nullptr;
+   };
+
+} // namespace nftsnap
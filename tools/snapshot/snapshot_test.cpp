@@ -0,0 +1,254 @@
+/**
+ *  Builds a snapshot from a generated row dump and checks every query
+ *  against the generated state.
+ *
+ *     snapshot_test [tokens]
+ *
+ *  The token count defaults to 100000, pass 10000000 to time the queries
+ *  at full scale.
+ */
+#include "snapshot.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace nftsnap;
+
+#define CHECK( cond ) do { if( !(cond) ) { \
+   std::fprintf( stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond ); std::exit( 1 ); } } while( 0 )
+
+namespace {
+
+   // Row bytes in the on-chain layout of the eosio.nft tables
+   class row_encoder {
+      public:
+         row_encoder& u8( uint8_t v ) { return raw( &v, sizeof(v) ); }
+         row_encoder& u64( uint64_t v ) { return raw( &v, sizeof(v) ); }
+         row_encoder& i64( int64_t v ) { return raw( &v, sizeof(v) ); }
+         row_encoder& str( const std::string& s ) {
+            uint32_t n = s.size();
+            do {
+               uint8_t b = n & 0x7f;
+               n >>= 7;
+               if( n ) b |= 0x80;
+               _data.push_back( char( b ) );
+            } while( n );
+            _data.insert( _data.end(), s.begin(), s.end() );
+            return *this;
+         }
+         row_encoder& asset( int64_t amount, uint64_t sym ) { return i64( amount ).u64( sym << 8 ); }
+         row_encoder& checksum256( const std::string& bytes ) { return raw( bytes.data(), 32 ); }
+
+         const std::vector<char>& data() const { return _data; }
+
+      private:
+         row_encoder& raw( const void* p, size_t n ) {
+            _data.insert( _data.end(), static_cast<const char*>( p ), static_cast<const char*>( p ) + n );
+            return *this;
+         }
+
+         std::vector<char> _data;
+   };
+
+   class dump_writer {
+      public:
+         explicit dump_writer( const std::string& path ) : _out( path, std::ios::binary | std::ios::trunc ) {
+            _out.write( row_dump_magic, sizeof(row_dump_magic) );
+         }
+
+         void row( uint64_t scope, const char* table, uint64_t primary_key, const row_encoder& row ) {
+            uint64_t keys[3] = { scope, string_to_name( table ), primary_key };
+            uint32_t size = row.data().size();
+            _out.write( reinterpret_cast<const char*>( keys ), sizeof(keys) );
+            _out.write( reinterpret_cast<const char*>( &size ), sizeof(size) );
+            _out.write( row.data().data(), size );
+         }
+
+      private:
+         std::ofstream _out;
+   };
+
+   double elapsed_ms( std::chrono::steady_clock::time_point started ) {
+      return std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - started ).count();
+   }
+
+   // Content hash of a generated token, the id bytes repeated
+   std::string hash_of( uint64_t id ) {
+      std::string bytes;
+      for( int i = 0; i < 4; ++i )
+         bytes.append( reinterpret_cast<const char*>( &id ), sizeof(id) );
+      return bytes;
+   }
+
+   std::string hex_of( const std::string& bytes ) {
+      static const char* digits = "0123456789abcdef";
+      std::string hex;
+      for( unsigned char b : bytes ) {
+         hex += digits[b >> 4];
+         hex += digits[b & 0x0f];
+      }
+      return hex;
+   }
+
+}
+
+int main( int argc, char** argv ) {
+   const uint64_t token_count = argc > 1 ? std::strtoull( argv[1], nullptr, 10 ) : 100000;
+   const std::string dump_path = "snapshot_test.rows";
+   const std::string snap_path = "snapshot_test.snap";
+
+   const uint64_t nft = string_to_symbol_code( "NFT" );
+   const uint64_t art = string_to_symbol_code( "ART" );
+   const uint64_t hsh = string_to_symbol_code( "HSH" );
+   std::vector<uint64_t> owners;
+   for( auto n : { "alice", "bob", "carol", "dave", "erin", "frank", "grace" } )
+      owners.push_back( string_to_name( n ) );
+
+   // Every 10th batch of 100 ids is issued as a range of ART and the
+   // 5th of every 10 as content-addressed HSH tokens, the rest are NFT
+   // tokens with uris spread over the owners, even ids with absolute
+   // uris issued before NFT had a base uri
+   std::map<std::pair<uint64_t, uint64_t>, int64_t> balances;
+   std::map<uint64_t, int64_t> supply;
+   uint64_t art_ranges = 0;
+   {
+      dump_writer dump( dump_path );
+      for( uint64_t start = 0; start < token_count; start += 100 ) {
+         auto count = std::min<uint64_t>( 100, token_count - start );
+         if( start / 100 % 10 == 9 ) {
+            auto owner = owners[ start / 100 % owners.size() ];
+            dump.row( art, "ranges", start, row_encoder().u64( start ).u64( count ).u64( owner ).u64( art ) );
+            balances[{ owner, art }] += count;
+            supply[art] += count;
+            art_ranges++;
+            continue;
+         }
+         if( start / 100 % 10 == 4 ) {
+            for( auto id = start; id < start + count; ++id ) {
+               auto owner = owners[ id % owners.size() ];
+               dump.row( hsh, "hashtokens", id, row_encoder().u64( id ).checksum256( hash_of( id ) ).u64( owner ).u64( hsh ) );
+               balances[{ owner, hsh }]++;
+               supply[hsh]++;
+            }
+            continue;
+         }
+         for( auto id = start; id < start + count; ++id ) {
+            auto owner = owners[ id % owners.size() ];
+            dump.row( nft, "tokens", id, row_encoder().u64( id ).u64( owner ).u64( nft ) );
+            auto uri = ( id % 2 ? "t" : "https://old.example/t" ) + std::to_string( id ) + ".json";
+            dump.row( nft, "tokenmeta", id, row_encoder().u64( id ).str( uri ).u8( id % 2 ? 0 : 1 ) );
+            balances[{ owner, nft }]++;
+            supply[nft]++;
+         }
+      }
+      for( const auto& b : balances ) {
+         if( b.first.second != art )
+            dump.row( b.first.first, "accounts", b.first.second, row_encoder().asset( b.second, b.first.second ) );
+      }
+      for( const auto& s : supply )
+         dump.row( s.first, "stat", s.first, row_encoder().asset( s.second, s.first ).u64( owners[0] ) );
+      // ART keeps no balance rows, its balances are counted from the tokens
+      dump.row( string_to_name( "eosio.nft" ), "collection", art,
+                row_encoder().u64( art ).str( "art" ).str( "https://cdn.example/art/" ).u8( 1 ) );
+      dump.row( string_to_name( "eosio.nft" ), "collection", nft,
+                row_encoder().u64( nft ).str( "nft" ).str( "https://cdn.example/nft/" ).u8( 0 ) );
+      dump.row( string_to_name( "eosio.nft" ), "collection", hsh,
+                row_encoder().u64( hsh ).str( "hsh" ).str( "ipfs://{hash}/meta.json" ).u8( 0 ) );
+   }
+
+   auto started = std::chrono::steady_clock::now();
+   auto stats = build_snapshot( abi::from_file( NFT_ABI_PATH ), dump_path, snap_path );
+   std::printf( "built %llu tokens in %.1f ms\n", (unsigned long long)stats.tokens, elapsed_ms( started ) );
+   CHECK( stats.tokens == token_count );
+   CHECK( stats.rows == token_count - supply[art] + art_ranges );
+   CHECK( stats.holders == owners.size() || token_count < owners.size() );
+   CHECK( stats.accounts == balances.size() );
+
+   snapshot snap( snap_path );
+   CHECK( snap.size() == stats.rows );
+   CHECK( snap.token_count() == token_count );
+
+   // All tokens of an owner, contiguous and in id order
+   started = std::chrono::steady_clock::now();
+   auto rows = snap.tokens_of( owners[1] );
+   std::printf( "tokens_of: %llu rows in %.3f ms\n", (unsigned long long)rows.count, elapsed_ms( started ) );
+   uint64_t owned = 0;
+   for( auto row = rows.first; row < rows.first + rows.count; ++row ) {
+      CHECK( snap.owner( row ) == owners[1] );
+      CHECK( row == rows.first || snap.id( row - 1 ) + snap.count( row - 1 ) <= snap.id( row ) );
+      owned += snap.count( row );
+   }
+   CHECK( int64_t(owned) == ( balances[std::make_pair( owners[1], nft )] + balances[std::make_pair( owners[1], art )] +
+                              balances[std::make_pair( owners[1], hsh )] ) );
+   CHECK( snap.tokens_of( string_to_name( "nobody" ) ).count == 0 );
+
+   // Supply per symbol
+   started = std::chrono::steady_clock::now();
+   int64_t total = 0;
+   for( const auto& s : snap.symbols() ) {
+      CHECK( s.supply == supply[s.sym] );
+      CHECK( int64_t(s.tokens) == s.supply );
+      total += s.supply;
+   }
+   std::printf( "supply of %zu symbols in %.3f ms\n", snap.symbols().size(), elapsed_ms( started ) );
+   CHECK( uint64_t(total) == token_count );
+
+   // Ranges stay one row each
+   auto art_rows = snap.rows_of_symbol( art );
+   CHECK( art_rows.size() == art_ranges );
+   int64_t art_tokens = 0;
+   for( auto row : art_rows ) {
+      CHECK( snap.symbol( row ) == art );
+      art_tokens += snap.count( row );
+   }
+   CHECK( art_tokens == supply[art] );
+
+   // Uris follow token::get_uri
+   if( token_count > 1000 ) {
+      auto first_art = *art_rows.begin();
+      CHECK( snap.id( first_art ) == 900 );
+      CHECK( snap.uri( first_art ) == "https://cdn.example/art/900" );
+      CHECK( snap.uri( first_art, 99 ) == "https://cdn.example/art/999" );
+   }
+   for( auto row = rows.first; row < rows.first + rows.count; ++row ) {
+      auto id = snap.id( row );
+      if( snap.symbol( row ) == nft )
+         CHECK( snap.uri( row ) == ( id % 2 ? "https://cdn.example/nft/t" : "https://old.example/t" ) + std::to_string( id ) + ".json" );
+      else if( snap.symbol( row ) == hsh )
+         CHECK( snap.uri( row ) == "ipfs://" + hex_of( hash_of( id ) ) + "/meta.json" );
+   }
+   CHECK( int64_t(snap.rows_of_symbol( hsh ).size()) == supply[hsh] );
+
+   for( const auto& b : balances )
+      CHECK( snap.balance( b.first.first, b.first.second ) == b.second );
+   CHECK( snap.accounts_of( owners[2] ).size() == ( token_count > 1000 ? 3 : 1 ) );
+
+   // One cheap issue creates a range of up to 2^62 tokens, it stays one row
+   const uint64_t huge = uint64_t(1) << 62;
+   const std::string huge_path = "snapshot_test_huge.snap";
+   {
+      dump_writer dump( dump_path );
+      dump.row( art, "ranges", 0, row_encoder().u64( 0 ).u64( huge ).u64( owners[0] ).u64( art ) );
+      dump.row( art, "stat", art, row_encoder().asset( huge, art ).u64( owners[0] ) );
+   }
+   stats = build_snapshot( abi::from_file( NFT_ABI_PATH ), dump_path, huge_path );
+   CHECK( stats.rows == 1 );
+   CHECK( stats.tokens == huge );
+   {
+      snapshot huge_snap( huge_path );
+      CHECK( huge_snap.holders().begin()->tokens == huge );
+      CHECK( huge_snap.find_symbol( art )->tokens == huge );
+   }
+
+   std::remove( dump_path.c_str() );
+   std::remove( snap_path.c_str() );
+   std::remove( huge_path.c_str() );
+   std::printf( "ok\n" );
+   return 0;
+}